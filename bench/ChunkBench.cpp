@@ -0,0 +1,273 @@
+// headless chunk generation + meshing benchmark (no window, GL or audio)
+//
+// usage: chunkbench [--chunks N] [--threads 1,2,4] [--seed S] [--json out.json] [--trace trace.json]
+//
+// every thread count generates and meshes the same N chunks (a square area
+// around the origin), workers pull chunk indices from a shared counter.
+// gen includes lighting the chunk, like the game's workers do.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "World/WorldGenerator.hpp"
+#include "World/ChunkMesher.hpp"
+#include "Profiler/Profiler.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+// heap box for one chunk of blocks (32 KB is a lot for a worker stack)
+struct BlockBuffer
+{
+    ChunkBlocks blocks;
+    ChunkLight light;
+};
+
+struct ChunkSample
+{
+    double genMs;
+    double meshMs;
+    size_t vertices;
+    size_t meshBytes;
+};
+
+struct RunResult
+{
+    int threads;
+    int chunks;
+    double seconds;
+    double chunksPerSec;
+    double verticesPerChunk;
+    double meshBytesPerChunk;
+    double blockBytesPerChunk;
+    double genP50, genP95, genP99;
+    double meshP50, meshP95, meshP99;
+    double totalP50, totalP95, totalP99;
+};
+
+static double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// nearest-rank percentile of an already sorted vector
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static RunResult runBench(const WorldGenerator &generator, int chunkCount, int threadCount)
+{
+    // square area of chunks around the origin, row by row
+    int side = (int)std::ceil(std::sqrt((double)chunkCount));
+
+    std::vector<ChunkSample> samples(chunkCount);
+    std::atomic<int> nextChunk{0};
+
+    Clock::time_point start = Clock::now();
+
+    auto worker = [&]()
+    {
+        PROFILE_THREAD("bench worker");
+
+        // per worker buffers, like a real chunk worker would reuse them
+        std::unique_ptr<BlockBuffer> buffer(new BlockBuffer);
+        SectionMesh mesh;
+
+        for (int i = nextChunk++; i < chunkCount; i = nextChunk++)
+        {
+            int chunkX = i % side - side / 2;
+            int chunkZ = i / side - side / 2;
+
+            Clock::time_point genStart = Clock::now();
+            {
+                PROFILE_SCOPE("genChunk");
+                generator.generateChunk(chunkX, chunkZ, buffer->blocks);
+            }
+            {
+                PROFILE_SCOPE("lightChunk");
+                computeChunkLight(buffer->blocks, buffer->light);
+            }
+            double genMs = msSince(genStart);
+
+            Clock::time_point meshStart = Clock::now();
+            {
+                PROFILE_SCOPE("buildMesh");
+                buildChunkMesh(buffer->blocks, buffer->light, chunkX * CHUNK_WIDTH, chunkZ * CHUNK_WIDTH, mesh);
+            }
+            double meshMs = msSince(meshStart);
+
+            ChunkSample &sample = samples[i];
+            sample.genMs = genMs;
+            sample.meshMs = meshMs;
+            sample.vertices = mesh.floatCount() / VERTEX_FLOATS;
+            sample.meshBytes = mesh.floatCount() * sizeof(float);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++)
+        workers.emplace_back(worker);
+    for (std::thread &t : workers)
+        t.join();
+
+    double seconds = msSince(start) / 1000.0;
+
+    std::vector<double> gen, mesh, total;
+    double vertexSum = 0.0, byteSum = 0.0;
+    for (const ChunkSample &sample : samples)
+    {
+        gen.push_back(sample.genMs);
+        mesh.push_back(sample.meshMs);
+        total.push_back(sample.genMs + sample.meshMs);
+        vertexSum += sample.vertices;
+        byteSum += sample.meshBytes;
+    }
+    std::sort(gen.begin(), gen.end());
+    std::sort(mesh.begin(), mesh.end());
+    std::sort(total.begin(), total.end());
+
+    RunResult r;
+    r.threads = threadCount;
+    r.chunks = chunkCount;
+    r.seconds = seconds;
+    r.chunksPerSec = chunkCount / seconds;
+    r.verticesPerChunk = vertexSum / chunkCount;
+    r.meshBytesPerChunk = byteSum / chunkCount;
+    r.blockBytesPerChunk = sizeof(ChunkBlocks);
+    r.genP50 = percentile(gen, 50);
+    r.genP95 = percentile(gen, 95);
+    r.genP99 = percentile(gen, 99);
+    r.meshP50 = percentile(mesh, 50);
+    r.meshP95 = percentile(mesh, 95);
+    r.meshP99 = percentile(mesh, 99);
+    r.totalP50 = percentile(total, 50);
+    r.totalP95 = percentile(total, 95);
+    r.totalP99 = percentile(total, 99);
+    return r;
+}
+
+static void writeJson(const char *path, const WorldGenParams &params, const std::vector<RunResult> &results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"chunkbench\",\n  \"seed\": %d,\n  \"chunkWidth\": %d,\n  \"chunkHeight\": %d,\n  \"runs\": [\n",
+            params.seed, CHUNK_WIDTH, CHUNK_HEIGHT);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const RunResult &r = results[i];
+        fprintf(f,
+                "    {\"threads\": %d, \"chunks\": %d, \"seconds\": %.6f, \"chunksPerSec\": %.2f,"
+                " \"verticesPerChunk\": %.1f, \"meshBytesPerChunk\": %.1f, \"blockBytesPerChunk\": %.1f,"
+                " \"genMs\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f},"
+                " \"meshMs\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f},"
+                " \"totalMs\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f}}%s\n",
+                r.threads, r.chunks, r.seconds, r.chunksPerSec,
+                r.verticesPerChunk, r.meshBytesPerChunk, r.blockBytesPerChunk,
+                r.genP50, r.genP95, r.genP99,
+                r.meshP50, r.meshP95, r.meshP99,
+                r.totalP50, r.totalP95, r.totalP99,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+static std::vector<int> parseThreadList(const char *arg)
+{
+    std::vector<int> list;
+    std::string s(arg);
+    size_t pos = 0;
+    while (pos < s.size())
+    {
+        size_t comma = s.find(',', pos);
+        if (comma == std::string::npos)
+            comma = s.size();
+        int n = atoi(s.substr(pos, comma - pos).c_str());
+        if (n > 0)
+            list.push_back(n);
+        pos = comma + 1;
+    }
+    return list;
+}
+
+int main(int argc, char **argv)
+{
+    int chunkCount = 256;
+    std::vector<int> threadCounts;
+    const char *jsonPath = nullptr;
+    const char *tracePath = nullptr;
+    WorldGenParams params;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--chunks") && i + 1 < argc)
+            chunkCount = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threadCounts = parseThreadList(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            params.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+            tracePath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--chunks N] [--threads 1,2,4] [--seed S] [--json out.json] [--trace trace.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (threadCounts.empty())
+    {
+        // 1, 2, 4, ... up to the hardware thread count
+        int hw = std::max(1u, std::thread::hardware_concurrency());
+        for (int n = 1; n < hw; n *= 2)
+            threadCounts.push_back(n);
+        threadCounts.push_back(hw);
+    }
+
+    WorldGenerator generator(params);
+
+    // warm up caches and the allocator so the first run isnt penalized
+    runBench(generator, std::min(chunkCount, 16), 1);
+
+    // every run is one "frame" of the trace
+    if (tracePath)
+        Profiler::beginCapture((int)threadCounts.size(), tracePath);
+
+    std::vector<RunResult> results;
+    printf("%-8s %-10s %-12s %-12s %-12s %-26s %-26s\n", "threads", "chunks/s", "verts/chunk", "mesh KB/ch", "block KB/ch",
+           "gen ms p50/p95/p99", "mesh ms p50/p95/p99");
+    for (int threads : threadCounts)
+    {
+        RunResult r = runBench(generator, chunkCount, threads);
+        results.push_back(r);
+        PROFILE_FRAME();
+
+        printf("%-8d %-10.1f %-12.1f %-12.1f %-12.1f %7.3f/%7.3f/%7.3f    %7.3f/%7.3f/%7.3f\n",
+               r.threads, r.chunksPerSec, r.verticesPerChunk, r.meshBytesPerChunk / 1024.0, r.blockBytesPerChunk / 1024.0,
+               r.genP50, r.genP95, r.genP99, r.meshP50, r.meshP95, r.meshP99);
+    }
+
+    if (jsonPath)
+        writeJson(jsonPath, params, results);
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+// chunk codec benchmark: compression ratio vs encode / decode speed on
+// generated terrain, for every codec compiled in
+//
+// usage: codecbench [--chunks N] [--seed S] [--rounds R] [--json out.json]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "World/WorldGenerator.hpp"
+#include "Storage/ChunkCodec.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+// heap box for one chunk of blocks
+struct BlockBuffer
+{
+    ChunkBlocks blocks;
+};
+
+struct CodecResult
+{
+    const char *name;
+    double bytesPerChunk;
+    double ratio;         // in memory size (int per block) / encoded size
+    double encodeMBps;    // of in memory size
+    double decodeMBps;
+    double encodeUsPerChunk;
+    double decodeUsPerChunk;
+    bool roundTrip;
+};
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static CodecResult runCodec(const ChunkCodec &codec, const std::vector<std::unique_ptr<BlockBuffer>> &chunks, int rounds)
+{
+    std::vector<std::vector<uint8_t>> encoded(chunks.size());
+    std::unique_ptr<BlockBuffer> decoded(new BlockBuffer);
+
+    // encode
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < chunks.size(); i++)
+            encodeChunk(chunks[i]->blocks, encoded[i], codec);
+    }
+    double encodeSeconds = secondsSince(start);
+
+    // decode
+    start = Clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < chunks.size(); i++)
+            decodeChunk(encoded[i].data(), encoded[i].size(), decoded->blocks);
+    }
+    double decodeSeconds = secondsSince(start);
+
+    // verify outside the timed loops
+    bool roundTrip = true;
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        totalBytes += encoded[i].size();
+        if (!decodeChunk(encoded[i].data(), encoded[i].size(), decoded->blocks) ||
+            memcmp(decoded->blocks, chunks[i]->blocks, sizeof(ChunkBlocks)) != 0)
+            roundTrip = false;
+    }
+
+    double processed = (double)sizeof(ChunkBlocks) * chunks.size() * rounds;
+    double count = (double)chunks.size() * rounds;
+
+    CodecResult result;
+    result.name = codec.name();
+    result.bytesPerChunk = (double)totalBytes / chunks.size();
+    result.ratio = sizeof(ChunkBlocks) / result.bytesPerChunk;
+    result.encodeMBps = processed / encodeSeconds / (1024.0 * 1024.0);
+    result.decodeMBps = processed / decodeSeconds / (1024.0 * 1024.0);
+    result.encodeUsPerChunk = encodeSeconds * 1e6 / count;
+    result.decodeUsPerChunk = decodeSeconds * 1e6 / count;
+    result.roundTrip = roundTrip;
+    return result;
+}
+
+static void writeJson(const char *path, const WorldGenParams &params, int chunkCount, const std::vector<CodecResult> &results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"codecbench\",\n  \"seed\": %d,\n  \"chunks\": %d,\n  \"chunkBytes\": %d,\n  \"codecs\": [\n",
+            params.seed, chunkCount, (int)sizeof(ChunkBlocks));
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const CodecResult &r = results[i];
+        fprintf(f,
+                "    {\"name\": \"%s\", \"bytesPerChunk\": %.1f, \"ratio\": %.2f, \"encodeMBps\": %.1f, \"decodeMBps\": %.1f,"
+                " \"encodeUsPerChunk\": %.3f, \"decodeUsPerChunk\": %.3f, \"roundTrip\": %s}%s\n",
+                r.name, r.bytesPerChunk, r.ratio, r.encodeMBps, r.decodeMBps, r.encodeUsPerChunk, r.decodeUsPerChunk,
+                r.roundTrip ? "true" : "false", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    int chunkCount = 256;
+    int rounds = 5;
+    const char *jsonPath = nullptr;
+    WorldGenParams params;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--chunks") && i + 1 < argc)
+            chunkCount = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            params.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--rounds") && i + 1 < argc)
+            rounds = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--chunks N] [--seed S] [--rounds R] [--json out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // same square area around the origin as chunkbench
+    WorldGenerator generator(params);
+    int side = (int)std::ceil(std::sqrt((double)chunkCount));
+    std::vector<std::unique_ptr<BlockBuffer>> chunks;
+    for (int i = 0; i < chunkCount; i++)
+    {
+        chunks.emplace_back(new BlockBuffer);
+        generator.generateChunk(i % side - side / 2, i / side - side / 2, chunks.back()->blocks);
+    }
+
+    std::vector<CodecResult> results;
+    printf("%-10s %-12s %-8s %-12s %-12s %-12s %-12s %s\n", "codec", "bytes/chunk", "ratio", "enc MB/s", "dec MB/s", "enc us/ch", "dec us/ch", "ok");
+    for (const ChunkCodec *codec : chunkCodecs())
+    {
+        CodecResult r = runCodec(*codec, chunks, rounds);
+        results.push_back(r);
+
+        printf("%-10s %-12.1f %-8.2f %-12.1f %-12.1f %-12.3f %-12.3f %s\n", r.name, r.bytesPerChunk, r.ratio,
+               r.encodeMBps, r.decodeMBps, r.encodeUsPerChunk, r.decodeUsPerChunk, r.roundTrip ? "yes" : "NO");
+    }
+
+    if (jsonPath)
+        writeJson(jsonPath, params, chunkCount, results);
+
+    for (const CodecResult &r : results)
+    {
+        if (!r.roundTrip)
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,324 @@
+// headless culling benchmark (no window, GL or audio)
+//
+// usage: cullbench [--views N] [--occluder-distance D] [--seed S] [--json out.json]
+//
+// meshes a generated area with a few sealed rooms dug under it, then looks
+// around from N random spots the way renderChunks does: the section graph
+// is walked from the camera, the solid columns of the chunks within D of
+// the camera are rasterized, and every non empty section the walk reached
+// is tested against them. "surface" stands on the terrain, "cave" in the
+// rooms. reports how many sections the view, the occluders and the graph
+// cull and what it costs per frame. the same is done with a 4x finer depth
+// buffer, sections only the coarse one culls are the ones a texel wide gap
+// can wrongly hide.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "World/WorldGenerator.hpp"
+#include "World/ChunkMesher.hpp"
+#include "Render/OcclusionCuller.hpp"
+#include "Render/SectionGraph.hpp"
+#include "glm/glm.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+typedef std::chrono::steady_clock Clock;
+
+struct BlockBuffer
+{
+    ChunkBlocks blocks;
+    ChunkLight light;
+};
+
+// what renderChunks keeps of a section
+struct SectionInfo
+{
+    int chunkX, chunkZ, section;
+    bool empty;
+    uint8_t occluderHeights[OCCLUDER_CELLS][OCCLUDER_CELLS];
+    uint8_t faceConnections[6];
+};
+
+// the meshed area, chunks x outer, z inner, their sections bottom up
+struct Area
+{
+    int radius;
+    std::vector<SectionInfo> sections;
+
+    const SectionInfo *find(int chunkX, int section, int chunkZ) const
+    {
+        if (std::abs(chunkX) > radius || std::abs(chunkZ) > radius)
+            return nullptr;
+        return &sections[((chunkX + radius) * (2 * radius + 1) + chunkZ + radius) * SECTION_COUNT + section];
+    }
+};
+
+// a sealed room of air, its floor at ROOM_FLOOR, always under the terrain
+const int ROOM_SIZE = 5;
+const int ROOM_HEIGHT = 4;
+const int ROOM_FLOOR = 3;
+
+struct ScenarioResult
+{
+    std::string scenario;
+    double sections, frustumCulled, occlusionCulled, graphCulled, drawn, onlyCoarse;
+    double cullP50, cullP99, cullMax;
+};
+
+static double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// nearest-rank percentile of an already sorted vector
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static void sectionBox(const SectionInfo &info, float min[3], float max[3])
+{
+    min[0] = (float)(info.chunkX * CHUNK_WIDTH);
+    min[1] = (float)(info.section * SECTION_HEIGHT);
+    min[2] = (float)(info.chunkZ * CHUNK_WIDTH);
+    max[0] = min[0] + CHUNK_WIDTH;
+    max[1] = min[1] + SECTION_HEIGHT;
+    max[2] = min[2] + CHUNK_WIDTH;
+}
+
+// the sections of a chunk follow each other, bottom up
+static void addOccluders(OcclusionCuller &culler, const SectionInfo *chunk)
+{
+    uint8_t sections[SECTION_COUNT][OCCLUDER_CELLS][OCCLUDER_CELLS];
+    for (int section = 0; section < SECTION_COUNT; section++)
+        memcpy(sections[section], chunk[section].occluderHeights, sizeof(sections[section]));
+    int heights[OCCLUDER_CELLS * OCCLUDER_CELLS];
+    chunkOccluderHeights(sections, heights);
+    culler.addOccluderHeightfield((float)(chunk->chunkX * CHUNK_WIDTH), (float)(chunk->chunkZ * CHUNK_WIDTH), (float)OCCLUDER_CELL, OCCLUDER_CELLS, heights);
+}
+
+static void buildArea(const WorldGenerator &generator, int radius, const std::vector<glm::ivec3> &rooms, Area &area)
+{
+    area.radius = radius;
+    area.sections.clear();
+    std::unique_ptr<BlockBuffer> buffer(new BlockBuffer());
+    SectionMesh mesh;
+    for (int x = -radius; x <= radius; x++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            generator.generateChunk(x, z, buffer->blocks);
+            for (const glm::ivec3 &room : rooms)
+            {
+                for (int worldX = room.x; worldX < room.x + ROOM_SIZE; worldX++)
+                    for (int worldZ = room.z; worldZ < room.z + ROOM_SIZE; worldZ++)
+                        for (int y = room.y; y < room.y + ROOM_HEIGHT; y++)
+                            if (worldToChunk(worldX) == x && worldToChunk(worldZ) == z)
+                                buffer->blocks[worldToLocal(worldX)][y][worldToLocal(worldZ)] = AIR;
+            }
+            computeChunkLight(buffer->blocks, buffer->light);
+            for (int section = 0; section < SECTION_COUNT; section++)
+            {
+                buildSectionMesh(buffer->blocks, buffer->light, section, x * CHUNK_WIDTH, z * CHUNK_WIDTH, mesh);
+                SectionInfo info;
+                info.chunkX = x;
+                info.chunkZ = z;
+                info.section = section;
+                info.empty = mesh.floatCount() == 0;
+                memcpy(info.occluderHeights, mesh.occluderHeights, sizeof(info.occluderHeights));
+                memcpy(info.faceConnections, mesh.faceConnections, sizeof(info.faceConnections));
+                area.sections.push_back(info);
+            }
+        }
+    }
+}
+
+// one frame of renderChunks' culling, writes each section's visibility
+// and how many sections the graph culled
+static int cullFrame(OcclusionCuller &culler, SectionGraph &graph, const Area &area, const glm::vec3 &eye, const glm::vec3 &front, const glm::mat4 &viewProjection, int occluderDistance, std::vector<char> &visible)
+{
+    graph.update(glm::value_ptr(eye), glm::value_ptr(front), area.radius, [&area](int chunkX, int section, int chunkZ) -> const uint8_t * {
+        const SectionInfo *info = area.find(chunkX, section, chunkZ);
+        return info ? info->faceConnections : nullptr;
+    });
+
+    int cameraChunkX = worldToChunk((int)std::floor(eye.x));
+    int cameraChunkZ = worldToChunk((int)std::floor(eye.z));
+    culler.beginFrame(glm::value_ptr(viewProjection));
+    const std::vector<SectionInfo> &sections = area.sections;
+    for (size_t i = 0; i < sections.size(); i += SECTION_COUNT)
+    {
+        if (std::abs(sections[i].chunkX - cameraChunkX) <= occluderDistance && std::abs(sections[i].chunkZ - cameraChunkZ) <= occluderDistance)
+            addOccluders(culler, &sections[i]);
+    }
+
+    int graphCulled = 0;
+    visible.assign(sections.size(), 0);
+    for (size_t i = 0; i < sections.size(); i++)
+    {
+        const SectionInfo &info = sections[i];
+        if (info.empty)
+            continue;
+        if (!graph.isReachable(info.chunkX, info.section, info.chunkZ))
+        {
+            graphCulled++;
+            continue;
+        }
+        float min[3], max[3];
+        sectionBox(info, min, max);
+        visible[i] = culler.isVisible(min, max);
+    }
+    return graphCulled;
+}
+
+// eyes[i] looking around at random
+static ScenarioResult runScenario(const char *scenario, const Area &area, const std::vector<glm::vec3> &eyes, int occluderDistance, unsigned int seed)
+{
+    OcclusionCuller culler;
+    OcclusionCuller fine(culler.getWidth() * 4, culler.getHeight() * 4);
+    SectionGraph graph;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    std::mt19937 random(seed);
+
+    int nonEmpty = 0;
+    for (const SectionInfo &info : area.sections)
+        nonEmpty += !info.empty;
+
+    std::vector<double> frameMs;
+    long long frustumCulled = 0, occlusionCulled = 0, graphCulled = 0, drawn = 0, onlyCoarse = 0;
+    std::vector<char> visible, fineVisible;
+    for (const glm::vec3 &eye : eyes)
+    {
+        float yaw = (float)(random() % 360);
+        float pitch = (float)(random() % 40) - 25.0f;
+        glm::vec3 front(cos(glm::radians(yaw)) * cos(glm::radians(pitch)), sin(glm::radians(pitch)), sin(glm::radians(yaw)) * cos(glm::radians(pitch)));
+        glm::mat4 viewProjection = projection * glm::lookAt(eye, eye + front, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        Clock::time_point start = Clock::now();
+        graphCulled += cullFrame(culler, graph, area, eye, front, viewProjection, occluderDistance, visible);
+        frameMs.push_back(msSince(start));
+
+        const OcclusionCuller::Stats &stats = culler.getStats();
+        frustumCulled += stats.frustumCulled;
+        occlusionCulled += stats.occlusionCulled;
+
+        cullFrame(fine, graph, area, eye, front, viewProjection, occluderDistance, fineVisible);
+        for (size_t i = 0; i < visible.size(); i++)
+        {
+            drawn += visible[i];
+            onlyCoarse += !visible[i] && fineVisible[i];
+        }
+    }
+    std::sort(frameMs.begin(), frameMs.end());
+
+    double perView = 1.0 / eyes.size();
+    ScenarioResult r;
+    r.scenario = scenario;
+    r.sections = nonEmpty;
+    r.frustumCulled = frustumCulled * perView;
+    r.occlusionCulled = occlusionCulled * perView;
+    r.graphCulled = graphCulled * perView;
+    r.drawn = drawn * perView;
+    r.onlyCoarse = onlyCoarse * perView;
+    r.cullP50 = percentile(frameMs, 50);
+    r.cullP99 = percentile(frameMs, 99);
+    r.cullMax = frameMs.back();
+    return r;
+}
+
+static void writeJson(const char *path, int seed, int viewCount, int occluderDistance, const std::vector<ScenarioResult> &results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"cullbench\",\n  \"seed\": %d,\n  \"views\": %d,\n  \"occluderDistance\": %d,\n  \"runs\": [\n", seed, viewCount, occluderDistance);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const ScenarioResult &r = results[i];
+        fprintf(f,
+                "    {\"scenario\": \"%s\", \"perView\": {\"sections\": %.1f, \"frustumCulled\": %.1f, \"occlusionCulled\": %.1f, \"graphCulled\": %.1f, \"drawn\": %.1f, \"onlyCoarseCulled\": %.2f},"
+                " \"cullMs\": {\"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f}}%s\n",
+                r.scenario.c_str(), r.sections, r.frustumCulled, r.occlusionCulled, r.graphCulled, r.drawn, r.onlyCoarse,
+                r.cullP50, r.cullP99, r.cullMax, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    int viewCount = 200;
+    int occluderDistance = 3;
+    const char *jsonPath = nullptr;
+    WorldGenParams params;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--views") && i + 1 < argc)
+            viewCount = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--occluder-distance") && i + 1 < argc)
+            occluderDistance = std::max(0, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            params.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--views N] [--occluder-distance D] [--seed S] [--json out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // render distance 12 around the origin, the views and rooms in the
+    // middle of it
+    const int radius = 12;
+    const int roomCount = 16;
+    WorldGenerator generator(params);
+    std::mt19937 random(params.seed + 1);
+    std::vector<glm::ivec3> rooms;
+    for (int i = 0; i < roomCount; i++)
+        rooms.push_back(glm::ivec3((int)(random() % (CHUNK_WIDTH * 8)) - CHUNK_WIDTH * 4, ROOM_FLOOR, (int)(random() % (CHUNK_WIDTH * 8)) - CHUNK_WIDTH * 4));
+    Area area;
+    buildArea(generator, radius, rooms, area);
+
+    std::vector<glm::vec3> surface, cave;
+    for (int view = 0; view < viewCount; view++)
+    {
+        int worldX = (int)(random() % (CHUNK_WIDTH * 8)) - CHUNK_WIDTH * 4;
+        int worldZ = (int)(random() % (CHUNK_WIDTH * 8)) - CHUNK_WIDTH * 4;
+        surface.push_back(glm::vec3((float)worldX + 0.5f, (float)generator.getTerrainY(worldX, worldZ) + 1.0f + 1.62f, (float)worldZ + 0.5f));
+        const glm::ivec3 &room = rooms[view % roomCount];
+        cave.push_back(glm::vec3(room.x + ROOM_SIZE * 0.5f, room.y + 1.62f, room.z + ROOM_SIZE * 0.5f));
+    }
+
+    std::vector<ScenarioResult> results;
+    results.push_back(runScenario("surface", area, surface, occluderDistance, params.seed + 2));
+    results.push_back(runScenario("cave", area, cave, occluderDistance, params.seed + 3));
+
+    printf("%-8s %-9s %-8s %-9s %-8s %-8s %-12s %-20s\n", "scenario", "sections", "frustum", "occluded", "graph", "drawn", "only coarse", "cull ms p50/p99/max");
+    for (const ScenarioResult &r : results)
+    {
+        printf("%-8s %-9.1f %-8.1f %-9.1f %-8.1f %-8.1f %-12.2f %6.3f/%6.3f/%6.3f\n",
+               r.scenario.c_str(), r.sections, r.frustumCulled, r.occlusionCulled, r.graphCulled, r.drawn, r.onlyCoarse,
+               r.cullP50, r.cullP99, r.cullMax);
+    }
+
+    if (jsonPath)
+        writeJson(jsonPath, params.seed, viewCount, occluderDistance, results);
+    return 0;
+}
@@ -0,0 +1,239 @@
+// headless edit-to-visible latency benchmark (no window, GL or audio)
+//
+// usage: editbench [--edits N] [--seed S] [--json out.json]
+//
+// edits random blocks of generated chunks the way setBlock does (write and
+// relight under the chunk lock, urgent remesh job on a worker pool) and measures
+// the time until the render thread could take the new mesh, once with the
+// whole column remeshed and once with only the touched sections. the GPU
+// upload is not included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "World/WorldGenerator.hpp"
+#include "World/ChunkMesher.hpp"
+#include "World/ChunkData.hpp"
+#include "Core/ThreadPool.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+struct BlockBuffer
+{
+    ChunkBlocks blocks;
+    ChunkLight light;
+};
+
+struct ModeResult
+{
+    const char *mode;
+    double meshP50, meshP95, meshP99;
+    double latencyP50, latencyP95, latencyP99;
+    double verticesPerEdit;
+};
+
+static double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// nearest-rank percentile of an already sorted vector
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+// the remesh job of one edit, like Chunk::remesh. sections == 0 means the
+// whole column as a single mesh
+static void remeshJob(ChunkData *data, unsigned int sections, double *meshMs)
+{
+    std::unique_ptr<BlockBuffer> copy(new BlockBuffer());
+    uint32_t version;
+    {
+        std::lock_guard<std::mutex> lock(data->blocksMutex);
+        version = data->getVersion();
+        memcpy(copy->blocks, data->blocks, sizeof(ChunkBlocks));
+        memcpy(copy->light, data->light, sizeof(ChunkLight));
+    }
+
+    Clock::time_point start = Clock::now();
+    if (sections == 0)
+    {
+        SectionMesh mesh;
+        buildChunkMesh(copy->blocks, copy->light, data->chunkX * CHUNK_WIDTH, data->chunkZ * CHUNK_WIDTH, mesh);
+        *meshMs = msSince(start);
+        data->publishMesh(0, std::move(mesh), version);
+        return;
+    }
+
+    for (int section = 0; section < SECTION_COUNT; section++)
+    {
+        if (!(sections & (1u << section)))
+            continue;
+        SectionMesh mesh;
+        buildSectionMesh(copy->blocks, copy->light, section, data->chunkX * CHUNK_WIDTH, data->chunkZ * CHUNK_WIDTH, mesh);
+        data->publishMesh(section, std::move(mesh), version);
+    }
+    *meshMs = msSince(start);
+}
+
+static ModeResult runMode(const char *mode, bool sectioned, std::vector<std::unique_ptr<ChunkData>> &chunks, ThreadPool &pool, int editCount, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::vector<double> mesh, latency;
+    double vertexSum = 0.0;
+
+    for (int i = 0; i < editCount; i++)
+    {
+        ChunkData &data = *chunks[random() % chunks.size()];
+        int x = random() % CHUNK_WIDTH;
+        int y = random() % CHUNK_HEIGHT;
+        int z = random() % CHUNK_WIDTH;
+
+        // the edit, as setBlock does it on the render thread
+        Clock::time_point start = Clock::now();
+        unsigned int lightSections;
+        {
+            std::lock_guard<std::mutex> lock(data.blocksMutex);
+            data.blocks[x][y][z] = data.blocks[x][y][z] == AIR ? STONE : AIR;
+            lightSections = updateLightAfterEdit(data.blocks, data.light, x, y, z);
+            data.markEdited();
+        }
+        unsigned int sections = sectioned ? sectionsTouchedBy(y) | lightSections : 0;
+        double meshMs = 0.0;
+        pool.enqueueUrgent(std::bind(remeshJob, &data, sections, &meshMs));
+
+        // the render thread polls once per frame, here as fast as it can
+        int waiting = 1;
+        if (sectioned)
+        {
+            waiting = 0;
+            for (int section = 0; section < SECTION_COUNT; section++)
+                waiting += (sections >> section) & 1;
+        }
+        SectionMesh taken;
+        while (waiting > 0)
+        {
+            for (int section = 0; section < SECTION_COUNT; section++)
+            {
+                if (data.takeMesh(section, taken))
+                {
+                    vertexSum += taken.floatCount() / VERTEX_FLOATS;
+                    waiting--;
+                }
+            }
+            if (waiting > 0)
+                std::this_thread::yield();
+        }
+        latency.push_back(msSince(start));
+        pool.wait(); // job fully done, meshMs is written
+        mesh.push_back(meshMs);
+    }
+
+    std::sort(mesh.begin(), mesh.end());
+    std::sort(latency.begin(), latency.end());
+
+    ModeResult r;
+    r.mode = mode;
+    r.meshP50 = percentile(mesh, 50);
+    r.meshP95 = percentile(mesh, 95);
+    r.meshP99 = percentile(mesh, 99);
+    r.latencyP50 = percentile(latency, 50);
+    r.latencyP95 = percentile(latency, 95);
+    r.latencyP99 = percentile(latency, 99);
+    r.verticesPerEdit = vertexSum / editCount;
+    return r;
+}
+
+static void writeJson(const char *path, int seed, int editCount, const std::vector<ModeResult> &results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"editbench\",\n  \"seed\": %d,\n  \"edits\": %d,\n  \"chunkHeight\": %d,\n  \"sectionHeight\": %d,\n  \"runs\": [\n",
+            seed, editCount, CHUNK_HEIGHT, SECTION_HEIGHT);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const ModeResult &r = results[i];
+        fprintf(f,
+                "    {\"mode\": \"%s\", \"verticesPerEdit\": %.1f,"
+                " \"meshMs\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f},"
+                " \"editToVisibleMs\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f}}%s\n",
+                r.mode, r.verticesPerEdit,
+                r.meshP50, r.meshP95, r.meshP99,
+                r.latencyP50, r.latencyP95, r.latencyP99,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    int editCount = 2000;
+    const char *jsonPath = nullptr;
+    WorldGenParams params;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--edits") && i + 1 < argc)
+            editCount = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            params.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--edits N] [--seed S] [--json out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // a few terrain chunks to edit
+    WorldGenerator generator(params);
+    std::vector<std::unique_ptr<ChunkData>> chunks;
+    for (int z = -2; z < 2; z++)
+    {
+        for (int x = -2; x < 2; x++)
+        {
+            chunks.emplace_back(new ChunkData(x, z));
+            generator.generateChunk(x, z, chunks.back()->blocks);
+            computeChunkLight(chunks.back()->blocks, chunks.back()->light);
+        }
+    }
+
+    ThreadPool pool(1, "remesh worker");
+
+    // warm up
+    runMode("warmup", true, chunks, pool, std::min(editCount, 100), 1);
+
+    std::vector<ModeResult> results;
+    results.push_back(runMode("column", false, chunks, pool, editCount, 42));
+    results.push_back(runMode("section", true, chunks, pool, editCount, 42));
+
+    printf("%-10s %-14s %-26s %-26s\n", "mode", "verts/edit", "mesh ms p50/p95/p99", "edit->visible ms p50/p95/p99");
+    for (const ModeResult &r : results)
+    {
+        printf("%-10s %-14.1f %7.3f/%7.3f/%7.3f    %7.3f/%7.3f/%7.3f\n",
+               r.mode, r.verticesPerEdit, r.meshP50, r.meshP95, r.meshP99, r.latencyP50, r.latencyP95, r.latencyP99);
+    }
+
+    if (jsonPath)
+        writeJson(jsonPath, params.seed, editCount, results);
+    return 0;
+}
@@ -0,0 +1,180 @@
+// headless level of detail benchmark (no window, GL or audio)
+//
+// usage: lodbench [--chunks N] [--seed S] [--json out.json]
+//
+// generates and meshes the same N chunks at full detail (generateChunk,
+// lighting, buildChunkMesh), as voxel LOD tiles of 2, 4 and 8 blocks per
+// cell (generateChunk, buildLodMesh) and as heightfield tiles of the same
+// (generateHeightmap, buildHeightfieldMesh), and reports the vertices,
+// mesh bytes, generation and mesh time per chunk of each, what a ring of
+// far chunks costs at that level.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "World/WorldGenerator.hpp"
+#include "World/ChunkMesher.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+struct BlockBuffer
+{
+    ChunkBlocks blocks;
+    ChunkLight light;
+};
+
+enum LodMode
+{
+    MODE_FULL,
+    MODE_VOXEL,
+    MODE_HEIGHTFIELD,
+};
+
+static const char *modeNames[] = {"full", "voxel", "height"};
+
+struct LevelResult
+{
+    LodMode mode;
+    int scale; // 1 for full detail
+    double verticesPerChunk;
+    double meshBytesPerChunk;
+    double genP50, genP99;
+    double meshP50, meshP99;
+};
+
+static double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// nearest-rank percentile of an already sorted vector
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static LevelResult runLevel(const WorldGenerator &generator, const std::vector<std::pair<int, int>> &positions, LodMode mode, int scale)
+{
+    std::vector<double> genMs, meshMs;
+    double vertexSum = 0.0;
+    std::unique_ptr<BlockBuffer> buffer(new BlockBuffer());
+    ChunkHeightmap map;
+    SectionMesh mesh;
+    for (const std::pair<int, int> &position : positions)
+    {
+        int initialX = position.first * CHUNK_WIDTH;
+        int initialZ = position.second * CHUNK_WIDTH;
+
+        Clock::time_point start = Clock::now();
+        if (mode == MODE_HEIGHTFIELD)
+            generator.generateHeightmap(position.first, position.second, map);
+        else
+            generator.generateChunk(position.first, position.second, buffer->blocks);
+        if (mode == MODE_FULL)
+            computeChunkLight(buffer->blocks, buffer->light);
+        genMs.push_back(msSince(start));
+
+        start = Clock::now();
+        if (mode == MODE_FULL)
+            buildChunkMesh(buffer->blocks, buffer->light, initialX, initialZ, mesh);
+        else if (mode == MODE_VOXEL)
+            buildLodMesh(buffer->blocks, scale, initialX, initialZ, mesh);
+        else
+            buildHeightfieldMesh(map, scale, initialX, initialZ, mesh);
+        meshMs.push_back(msSince(start));
+        vertexSum += mesh.floatCount() / VERTEX_FLOATS;
+    }
+    std::sort(genMs.begin(), genMs.end());
+    std::sort(meshMs.begin(), meshMs.end());
+
+    LevelResult r;
+    r.mode = mode;
+    r.scale = scale;
+    r.verticesPerChunk = vertexSum / positions.size();
+    r.meshBytesPerChunk = r.verticesPerChunk * VERTEX_FLOATS * sizeof(float);
+    r.genP50 = percentile(genMs, 50);
+    r.genP99 = percentile(genMs, 99);
+    r.meshP50 = percentile(meshMs, 50);
+    r.meshP99 = percentile(meshMs, 99);
+    return r;
+}
+
+static void writeJson(const char *path, int seed, int chunkCount, const std::vector<LevelResult> &results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"lodbench\",\n  \"seed\": %d,\n  \"chunks\": %d,\n  \"runs\": [\n", seed, chunkCount);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const LevelResult &r = results[i];
+        fprintf(f,
+                "    {\"mode\": \"%s\", \"scale\": %d, \"verticesPerChunk\": %.1f, \"meshBytesPerChunk\": %.1f,"
+                " \"genMs\": {\"p50\": %.4f, \"p99\": %.4f}, \"meshMs\": {\"p50\": %.4f, \"p99\": %.4f}}%s\n",
+                modeNames[r.mode], r.scale, r.verticesPerChunk, r.meshBytesPerChunk,
+                r.genP50, r.genP99, r.meshP50, r.meshP99, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    int chunkCount = 256;
+    const char *jsonPath = nullptr;
+    WorldGenParams params;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--chunks") && i + 1 < argc)
+            chunkCount = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            params.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--chunks N] [--seed S] [--json out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // a square area around the origin
+    WorldGenerator generator(params);
+    int side = std::max(1, (int)std::ceil(std::sqrt((double)chunkCount)));
+    std::vector<std::pair<int, int>> positions;
+    for (int i = 0; i < chunkCount; i++)
+        positions.push_back(std::make_pair(i % side - side / 2, i / side - side / 2));
+
+    std::vector<LevelResult> results;
+    results.push_back(runLevel(generator, positions, MODE_FULL, 1));
+    for (int scale = 2; scale <= 8; scale *= 2)
+        results.push_back(runLevel(generator, positions, MODE_VOXEL, scale));
+    for (int scale = 2; scale <= 8; scale *= 2)
+        results.push_back(runLevel(generator, positions, MODE_HEIGHTFIELD, scale));
+
+    printf("%-7s %-6s %-12s %-12s %-10s %-18s %-18s\n", "mode", "scale", "verts/chunk", "mesh KB/ch", "of full", "gen ms p50/p99", "mesh ms p50/p99");
+    for (const LevelResult &r : results)
+    {
+        printf("%-7s %-6d %-12.1f %-12.1f %-10.3f %7.3f/%7.3f    %7.3f/%7.3f\n",
+               modeNames[r.mode], r.scale, r.verticesPerChunk, r.meshBytesPerChunk / 1024.0, r.verticesPerChunk / results[0].verticesPerChunk,
+               r.genP50, r.genP99, r.meshP50, r.meshP99);
+    }
+
+    if (jsonPath)
+        writeJson(jsonPath, params.seed, chunkCount, results);
+    return 0;
+}
@@ -0,0 +1,203 @@
+// headless block picking benchmark (no window, GL or audio)
+//
+// usage: raycastbench [--rays N] [--seed S] [--json out.json]
+//
+// casts random rays from above the terrain of a generated area with a few
+// reach distances, through raycastBlocks and through a naive fixed step
+// ray march that looks every sample up in the chunk map. the march is the
+// baseline, and its hits are compared with the traversal's as a sanity check
+// (it can clip block corners, so a few disagreements are expected).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "World/WorldGenerator.hpp"
+#include "World/Raycast.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+struct BlockBuffer
+{
+    ChunkBlocks blocks;
+};
+
+typedef std::map<std::pair<int, int>, std::unique_ptr<BlockBuffer>> ChunkMap;
+
+struct Ray
+{
+    float origin[3];
+    float dir[3];
+};
+
+struct ReachResult
+{
+    float reach;
+    double ddaNsPerRay;
+    double marchNsPerRay;
+    double hitRate;
+    double agreement; // of the rays, same hit block (or both miss)
+};
+
+static const ChunkBlocks *findChunk(const ChunkMap &chunks, int chunkX, int chunkZ)
+{
+    auto it = chunks.find(std::make_pair(chunkX, chunkZ));
+    return it == chunks.end() ? nullptr : &it->second->blocks;
+}
+
+// baseline: sample the ray every 1/20 block, one map lookup per sample
+static bool marchRay(const ChunkMap &chunks, const Ray &ray, float reach, int &hitX, int &hitY, int &hitZ)
+{
+    const float step = 0.05f;
+    float length = std::sqrt(ray.dir[0] * ray.dir[0] + ray.dir[1] * ray.dir[1] + ray.dir[2] * ray.dir[2]);
+    for (float t = 0.0f; t <= reach; t += step)
+    {
+        int x = (int)std::floor(ray.origin[0] + ray.dir[0] / length * t);
+        int y = (int)std::floor(ray.origin[1] + ray.dir[1] / length * t);
+        int z = (int)std::floor(ray.origin[2] + ray.dir[2] / length * t);
+        if (y < 0 || y >= CHUNK_HEIGHT)
+            continue;
+
+        const ChunkBlocks *blocks = findChunk(chunks, worldToChunk(x), worldToChunk(z));
+        if (!blocks)
+            return false;
+        if (isSolidBlock((*blocks)[worldToLocal(x)][y][worldToLocal(z)]))
+        {
+            hitX = x;
+            hitY = y;
+            hitZ = z;
+            return true;
+        }
+    }
+    return false;
+}
+
+static ReachResult runReach(const ChunkMap &chunks, const std::vector<Ray> &rays, float reach)
+{
+    ChunkLookup lookup = [&chunks](int chunkX, int chunkZ) { return findChunk(chunks, chunkX, chunkZ); };
+
+    std::vector<RaycastHit> hits(rays.size());
+    std::vector<bool> hitFlags(rays.size());
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+        const Ray &ray = rays[i];
+        hitFlags[i] = raycastBlocks(lookup, ray.origin[0], ray.origin[1], ray.origin[2], ray.dir[0], ray.dir[1], ray.dir[2], reach, hits[i]);
+    }
+    double ddaNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    int hitCount = 0, agree = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+        int x = 0, y = 0, z = 0;
+        bool marchHit = marchRay(chunks, rays[i], reach, x, y, z);
+        if (marchHit == hitFlags[i] && (!marchHit || (x == hits[i].x && y == hits[i].y && z == hits[i].z)))
+            agree++;
+        if (hitFlags[i])
+            hitCount++;
+    }
+    double marchNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    ReachResult r;
+    r.reach = reach;
+    r.ddaNsPerRay = ddaNs / rays.size();
+    r.marchNsPerRay = marchNs / rays.size();
+    r.hitRate = (double)hitCount / rays.size();
+    r.agreement = (double)agree / rays.size();
+    return r;
+}
+
+static void writeJson(const char *path, int seed, int rayCount, const std::vector<ReachResult> &results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"raycastbench\",\n  \"seed\": %d,\n  \"rays\": %d,\n  \"runs\": [\n", seed, rayCount);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const ReachResult &r = results[i];
+        fprintf(f, "    {\"reach\": %.1f, \"ddaNsPerRay\": %.1f, \"marchNsPerRay\": %.1f, \"hitRate\": %.4f, \"agreement\": %.4f}%s\n",
+                r.reach, r.ddaNsPerRay, r.marchNsPerRay, r.hitRate, r.agreement, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    int rayCount = 100000;
+    const char *jsonPath = nullptr;
+    WorldGenParams params;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--rays") && i + 1 < argc)
+            rayCount = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            params.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--rays N] [--seed S] [--json out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // 16x16 chunks around the origin
+    const int radius = 8;
+    WorldGenerator generator(params);
+    ChunkMap chunks;
+    for (int z = -radius; z < radius; z++)
+    {
+        for (int x = -radius; x < radius; x++)
+        {
+            std::unique_ptr<BlockBuffer> buffer(new BlockBuffer());
+            generator.generateChunk(x, z, buffer->blocks);
+            chunks[std::make_pair(x, z)] = std::move(buffer);
+        }
+    }
+
+    // eye height over the middle of the area, looking anywhere but up
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-radius * CHUNK_WIDTH * 0.5f, radius * CHUNK_WIDTH * 0.5f);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+    std::vector<Ray> rays(rayCount);
+    for (Ray &ray : rays)
+    {
+        ray.origin[0] = position(random);
+        ray.origin[2] = position(random);
+        ray.origin[1] = generator.getTerrainY((int)std::floor(ray.origin[0]), (int)std::floor(ray.origin[2])) + 2.6f;
+        ray.dir[0] = direction(random);
+        ray.dir[1] = -std::fabs(direction(random));
+        ray.dir[2] = direction(random);
+    }
+
+    const float reaches[] = {5.0f, 16.0f, 64.0f};
+    std::vector<ReachResult> results;
+    printf("%-8s %-14s %-14s %-10s %-10s\n", "reach", "dda ns/ray", "march ns/ray", "hit rate", "agreement");
+    for (float reach : reaches)
+    {
+        ReachResult r = runReach(chunks, rays, reach);
+        results.push_back(r);
+        printf("%-8.1f %-14.1f %-14.1f %-10.3f %-10.3f\n", r.reach, r.ddaNsPerRay, r.marchNsPerRay, r.hitRate, r.agreement);
+    }
+
+    if (jsonPath)
+        writeJson(jsonPath, params.seed, rayCount, results);
+    return 0;
+}
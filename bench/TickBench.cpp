@@ -0,0 +1,293 @@
+// headless block tick benchmark (no window, GL or audio)
+//
+// usage: tickbench [--budget MICROS] [--workers N] [--seed S] [--json out.json]
+//
+// runs BlockTicker on a generated area the way the simulation thread does
+// (writes relight the chunk, remeshes are collected per chunk and requested
+// once per tick).
+//
+// "spring" and "flood" are scheduled ticks only: a single water source on
+// the terrain, and a square of sources above it (a large lake filling at
+// once), ticked until the water settles. reports the tick times and how
+// many remesh requests the per chunk batching saved over one per write.
+//
+// "random-1" and "random-N" are random ticks only, a fixed number of ticks
+// sampling every grass / leaves section of the area, on one worker and on
+// --workers, for the speedup of the 3x3 chunk groups.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "World/WorldGenerator.hpp"
+#include "World/BlockTicks.hpp"
+#include "World/ChunkMesher.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+struct BlockBuffer
+{
+    ChunkBlocks blocks;
+    ChunkLight light;
+    int randomTicked[SECTION_COUNT];
+};
+
+typedef std::map<std::pair<int, int>, std::unique_ptr<BlockBuffer>> ChunkMap;
+
+struct ScenarioResult
+{
+    std::string scenario;
+    int sources;
+    int ticks;
+    long long writes;
+    long long remeshRequests; // batched, per chunk and tick
+    double tickP50, tickP99, tickMax;
+    double totalMs;
+};
+
+static double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// nearest-rank percentile of an already sorted vector
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static void generateArea(const WorldGenerator &generator, int radius, ChunkMap &chunks)
+{
+    chunks.clear();
+    for (int z = -radius; z < radius; z++)
+    {
+        for (int x = -radius; x < radius; x++)
+        {
+            std::unique_ptr<BlockBuffer> buffer(new BlockBuffer());
+            generator.generateChunk(x, z, buffer->blocks);
+            computeChunkLight(buffer->blocks, buffer->light);
+            countRandomTicked(buffer->blocks, buffer->randomTicked);
+            chunks[std::make_pair(x, z)] = std::move(buffer);
+        }
+    }
+}
+
+// the world of one scenario, like the glue in main.cpp. the random tick
+// workers write from several threads, hence the lock
+struct BenchWorld
+{
+    ChunkMap &chunks;
+    std::mutex mutex;
+    std::map<std::pair<int, int>, unsigned int> remeshes;
+    long long writes = 0;
+
+    explicit BenchWorld(ChunkMap &chunks) : chunks(chunks) {}
+
+    TickWorld tickWorld(bool randomTicks)
+    {
+        TickWorld world;
+        world.get = [this](int x, int y, int z) {
+            auto it = chunks.find(std::make_pair(worldToChunk(x), worldToChunk(z)));
+            return it == chunks.end() ? -1 : it->second->blocks[worldToLocal(x)][y][worldToLocal(z)];
+        };
+        world.set = [this](int x, int y, int z, int block) {
+            auto key = std::make_pair(worldToChunk(x), worldToChunk(z));
+            auto it = chunks.find(key);
+            if (it == chunks.end())
+                return;
+            BlockBuffer &buffer = *it->second;
+            int &slot = buffer.blocks[worldToLocal(x)][y][worldToLocal(z)];
+            buffer.randomTicked[y / SECTION_HEIGHT] += (int)isRandomTicked(block) - (int)isRandomTicked(slot);
+            slot = block;
+            unsigned int sections = sectionsTouchedBy(y) | updateLightAfterEdit(buffer.blocks, buffer.light, worldToLocal(x), y, worldToLocal(z));
+            std::lock_guard<std::mutex> lock(mutex);
+            remeshes[key] |= sections;
+            writes++;
+        };
+        world.listChunks = [this, randomTicks](std::vector<TickChunk> &list) {
+            if (!randomTicks)
+                return;
+            for (auto &it : chunks)
+            {
+                unsigned int sections = 0;
+                for (int section = 0; section < SECTION_COUNT; section++)
+                {
+                    if (it.second->randomTicked[section] > 0)
+                        sections |= 1u << section;
+                }
+                if (sections != 0)
+                    list.push_back(TickChunk{it.first.first, it.first.second, sections});
+            }
+        };
+        return world;
+    }
+};
+
+static ScenarioResult summarize(const std::string &scenario, int sources, std::vector<double> &tickMs, const BenchWorld &world, long long remeshRequests, double totalMs)
+{
+    std::sort(tickMs.begin(), tickMs.end());
+
+    ScenarioResult r;
+    r.scenario = scenario;
+    r.sources = sources;
+    r.ticks = (int)tickMs.size();
+    r.writes = world.writes;
+    r.remeshRequests = remeshRequests;
+    r.tickP50 = percentile(tickMs, 50);
+    r.tickP99 = percentile(tickMs, 99);
+    r.tickMax = tickMs.empty() ? 0.0 : tickMs.back();
+    r.totalMs = totalMs;
+    return r;
+}
+
+static ScenarioResult runWater(const char *scenario, ChunkMap &chunks, const std::vector<std::pair<int, int>> &sourceColumns, int sourceY, int budget)
+{
+    BenchWorld world(chunks);
+    BlockTicker ticker(world.tickWorld(false), 1, budget);
+    for (const std::pair<int, int> &column : sourceColumns)
+    {
+        int y = sourceY;
+        if (y < 0)
+        {
+            // first air above the terrain
+            y = CHUNK_HEIGHT - 1;
+            while (y > 0 && ticker.getBlock(column.first, y - 1, column.second) == AIR)
+                y--;
+        }
+        ticker.setBlock(column.first, y, column.second, makeBlock(WATER, WATER_SOURCE));
+    }
+    world.remeshes.clear();
+    world.writes = 0;
+
+    std::vector<double> tickMs;
+    long long remeshRequests = 0;
+    Clock::time_point start = Clock::now();
+    while (ticker.getScheduledCount() > 0)
+    {
+        Clock::time_point tickStart = Clock::now();
+        ticker.tick();
+        tickMs.push_back(msSince(tickStart));
+        remeshRequests += world.remeshes.size();
+        world.remeshes.clear();
+    }
+    return summarize(scenario, (int)sourceColumns.size(), tickMs, world, remeshRequests, msSince(start));
+}
+
+static ScenarioResult runRandom(ChunkMap &chunks, int workers, int ticks, int ticksPerSection, int budget)
+{
+    BenchWorld world(chunks);
+    BlockTicker ticker(world.tickWorld(true), workers, budget, ticksPerSection);
+
+    std::vector<double> tickMs;
+    long long remeshRequests = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < ticks; i++)
+    {
+        Clock::time_point tickStart = Clock::now();
+        ticker.tick();
+        tickMs.push_back(msSince(tickStart));
+        remeshRequests += world.remeshes.size();
+        world.remeshes.clear();
+    }
+    return summarize("random-" + std::to_string(workers), 0, tickMs, world, remeshRequests, msSince(start));
+}
+
+static void writeJson(const char *path, int seed, int budget, const std::vector<ScenarioResult> &results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"tickbench\",\n  \"seed\": %d,\n  \"budgetMicros\": %d,\n  \"runs\": [\n", seed, budget);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const ScenarioResult &r = results[i];
+        fprintf(f,
+                "    {\"scenario\": \"%s\", \"sources\": %d, \"ticks\": %d, \"writes\": %lld, \"remeshRequests\": %lld,"
+                " \"tickMs\": {\"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f}, \"totalMs\": %.2f}%s\n",
+                r.scenario.c_str(), r.sources, r.ticks, r.writes, r.remeshRequests,
+                r.tickP50, r.tickP99, r.tickMax, r.totalMs, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    int budget = 1000000; // effectively none, the scenarios measure the full work
+    int workers = std::max(2, (int)std::thread::hardware_concurrency() - 1);
+    const char *jsonPath = nullptr;
+    WorldGenParams params;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--budget") && i + 1 < argc)
+            budget = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--workers") && i + 1 < argc)
+            workers = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            params.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--budget MICROS] [--workers N] [--seed S] [--json out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // 8x8 chunks around the origin, fresh for every scenario
+    const int radius = 4;
+    WorldGenerator generator(params);
+    ChunkMap chunks;
+    std::vector<ScenarioResult> results;
+
+    generateArea(generator, radius, chunks);
+    results.push_back(runWater("spring", chunks, {std::make_pair(0, 0)}, -1, budget));
+
+    generateArea(generator, radius, chunks);
+    std::vector<std::pair<int, int>> flood;
+    for (int z = -16; z < 16; z++)
+        for (int x = -16; x < 16; x++)
+            flood.push_back(std::make_pair(x, z));
+    results.push_back(runWater("flood", chunks, flood, CHUNK_HEIGHT - 1, budget));
+
+    // many samples per section, so the ticks are long enough to split
+    const int randomTicks = 200;
+    const int samplesPerSection = 256;
+    generateArea(generator, radius, chunks);
+    results.push_back(runRandom(chunks, 1, randomTicks, samplesPerSection, budget));
+    generateArea(generator, radius, chunks);
+    results.push_back(runRandom(chunks, workers, randomTicks, samplesPerSection, budget));
+
+    printf("%-10s %-8s %-7s %-9s %-16s %-24s %-10s\n", "scenario", "sources", "ticks", "writes", "remesh batched", "tick ms p50/p99/max", "total ms");
+    for (const ScenarioResult &r : results)
+    {
+        printf("%-10s %-8d %-7d %-9lld %-7lld (%-6lld) %7.3f/%7.3f/%7.3f  %-10.1f\n",
+               r.scenario.c_str(), r.sources, r.ticks, r.writes, r.remeshRequests, r.writes, r.tickP50, r.tickP99, r.tickMax, r.totalMs);
+    }
+
+    // the random runs are the last two
+    const ScenarioResult &one = results[results.size() - 2], &many = results.back();
+    printf("random ticks on %d workers: %.2fx the speed of one (%u hardware threads)\n",
+           workers, one.totalMs / std::max(many.totalMs, 0.001), std::thread::hardware_concurrency());
+
+    if (jsonPath)
+        writeJson(jsonPath, params.seed, budget, results);
+    return 0;
+}
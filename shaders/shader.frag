@@ -3,10 +3,25 @@
 out vec4 FragColor;
 
 in vec2 TexCoord;
+in float Light;
+in float Ao;
+in float Water;
 
 uniform sampler2D curTexture;
+uniform int alphaTest; // 1 in the cutout pass (leaves)
 
 void main()
 {
-    FragColor = texture(curTexture, TexCoord);
+    // the brighter of sky and block light, each level 80% of the one above
+    float sky = floor(Light / 16.0f + 0.01f);
+    float block = Light - sky * 16.0f;
+    float level = max(sky, block);
+    float brightness = max(pow(0.8f, 15.0f - level), 0.05f);
+    brightness *= 0.55f + 0.15f * Ao;
+
+    // water has no tile in the atlas, a flat see through blue
+    vec4 color = Water > 0.5f ? vec4(0.25f, 0.45f, 0.9f, 0.65f) : texture(curTexture, TexCoord);
+    if (alphaTest == 1 && color.a < 0.5f)
+        discard;
+    FragColor = vec4(color.rgb * brightness, color.a);
 }
@@ -4,7 +4,12 @@ layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec2 localUv;
 layout(location = 2) in float vFaceId;
 layout(location = 3) in float blockType;
+layout(location = 4) in float vLight; // sky light * 16 + block light
+layout(location = 5) in float vAo;    // 0 occluded .. 3 open
 out vec2 TexCoord;
+out float Light;
+out float Ao;
+out float Water;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -74,4 +79,7 @@ void main()
 
     gl_Position = projection * view * model * vec4(vPos, 1.0);
     TexCoord = finalUv;
+    Light = vLight;
+    Ao = vAo;
+    Water = blockType == 7.0f ? 1.0f : 0.0f;
 }
@@ -0,0 +1,85 @@
+#include "Core/SimulationLoop.hpp"
+#include "Profiler/Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+SimulationLoop::SimulationLoop(double tickSeconds, std::function<void()> tick, const char *name, int maxCatchUpTicks)
+    : tickSeconds(tickSeconds), tick(std::move(tick)), name(name), maxCatchUpTicks(maxCatchUpTicks)
+{
+    thread = std::thread(&SimulationLoop::run, this);
+}
+
+SimulationLoop::~SimulationLoop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+float SimulationLoop::getAlpha() const
+{
+    uint64_t last = lastTickMicros.load(std::memory_order_acquire);
+    if (last == 0)
+        return 1.0f;
+    double alpha = (Profiler::nowMicros() - last) / (tickSeconds * 1000000.0);
+    return (float)std::min(std::max(alpha, 0.0), 1.0);
+}
+
+SimulationLoop::Stats SimulationLoop::getStats()
+{
+    Stats stats;
+    stats.ticks = ticks.load(std::memory_order_relaxed);
+    stats.droppedTicks = droppedTicks.load(std::memory_order_relaxed);
+    stats.lastTickMs = lastTickDuration.load(std::memory_order_relaxed) / 1000.0;
+    stats.maxTickMs = maxTickDuration.exchange(0, std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+void SimulationLoop::run()
+{
+    PROFILE_THREAD(name);
+
+    const Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tickSeconds));
+    Clock::time_point next = Clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping)
+    {
+        if (wake.wait_until(lock, next, [this] { return stopping; }))
+            break;
+        lock.unlock();
+
+        uint64_t start = Profiler::nowMicros();
+        {
+            PROFILE_SCOPE("tick");
+            tick();
+        }
+        uint64_t end = Profiler::nowMicros();
+
+        lastTickMicros.store(start, std::memory_order_release);
+        ticks.fetch_add(1, std::memory_order_relaxed);
+        lastTickDuration.store(end - start, std::memory_order_relaxed);
+        uint64_t max = maxTickDuration.load(std::memory_order_relaxed);
+        while (end - start > max && !maxTickDuration.compare_exchange_weak(max, end - start, std::memory_order_relaxed))
+        {
+        }
+
+        // catch up on missed ticks, but not on a whole hitch worth of them
+        next += step;
+        Clock::time_point now = Clock::now();
+        if (now - next > step * maxCatchUpTicks)
+        {
+            uint64_t behind = (uint64_t)((now - next) / step);
+            droppedTicks.fetch_add(behind, std::memory_order_relaxed);
+            next += step * (Clock::duration::rep)behind;
+        }
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// runs the game logic at a fixed tick rate on its own thread, independent
+// of the frame rate. a slow frame doesnt slow the ticks down and a slow tick
+// doesnt hold a frame. the render thread draws the last two ticks blended by
+// getAlpha(). when ticks fall behind by more than maxCatchUpTicks, the
+// missed ones are dropped instead of run back to back
+class SimulationLoop
+{
+public:
+    SimulationLoop(double tickSeconds, std::function<void()> tick, const char *name, int maxCatchUpTicks = 5);
+
+    // stops after the running tick
+    ~SimulationLoop();
+
+    SimulationLoop(const SimulationLoop &) = delete;
+    SimulationLoop &operator=(const SimulationLoop &) = delete;
+
+    double getTickSeconds() const { return tickSeconds; }
+
+    // how far now is past the start of the last tick, in ticks, 0..1
+    float getAlpha() const;
+
+    struct Stats
+    {
+        uint64_t ticks;
+        uint64_t droppedTicks;
+        double lastTickMs;
+        double maxTickMs; // since the last getStats
+    };
+    Stats getStats();
+
+private:
+    const double tickSeconds;
+    const std::function<void()> tick;
+    const char *name;
+    const int maxCatchUpTicks;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::atomic<uint64_t> lastTickMicros{0};
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> droppedTicks{0};
+    std::atomic<uint64_t> lastTickDuration{0};
+    std::atomic<uint64_t> maxTickDuration{0};
+
+    // last member, started once everything above is initialized
+    std::thread thread;
+
+    void run();
+};
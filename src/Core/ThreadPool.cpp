@@ -0,0 +1,89 @@
+#include "Core/ThreadPool.hpp"
+#include "Profiler/Profiler.hpp"
+
+ThreadPool::ThreadPool(int threadCount, const char *name) : name(name)
+{
+    if (threadCount <= 0)
+    {
+        int hw = (int)std::thread::hardware_concurrency();
+        threadCount = hw > 1 ? hw - 1 : 1;
+    }
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    idle.notify_all();
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::enqueueUrgent(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_front(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return jobs.empty() && runningJobs == 0; });
+}
+
+int ThreadPool::getQueuedCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)jobs.size();
+}
+
+void ThreadPool::workerLoop()
+{
+    PROFILE_THREAD(name);
+
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping)
+                return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            runningJobs++;
+        }
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            runningJobs--;
+        }
+        idle.notify_all();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads pulling jobs from one FIFO queue.
+// the destructor drops jobs that havent started and joins the workers
+class ThreadPool
+{
+public:
+    // threadCount <= 0 means one per hardware thread, minus one for the render thread
+    ThreadPool(int threadCount, const char *name);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void enqueue(std::function<void()> job);
+
+    // runs before everything already queued, for latency sensitive work
+    void enqueueUrgent(std::function<void()> job);
+
+    // blocks until every queued job has run
+    void wait();
+
+    int getThreadCount() const { return (int)workers.size(); }
+    int getQueuedCount();
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    int runningJobs = 0;
+    bool stopping = false;
+    const char *name;
+
+    void workerLoop();
+};
@@ -0,0 +1,179 @@
+#include "Physics/PlayerPhysics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const float GRAVITY = 28.0f;       // blocks / s^2
+static const float TERMINAL_SPEED = 60.0f; // blocks / s
+static const float JUMP_SPEED = 8.4f;      // a bit over one block high
+static const float WALK_SPEED = 4.3f;
+static const float FLY_SPEED = 10.0f;
+
+// keeps the box this far off the blocks it touches, so touching isnt
+// overlapping on the next step
+static const float SKIN = 0.001f;
+
+// block reads for one step, the chunk lookup only runs when the block is
+// in another chunk than the last one
+class BlockReader
+{
+public:
+    explicit BlockReader(const ChunkLookup &lookup) : lookup(lookup) {}
+
+    bool isSolid(int x, int y, int z)
+    {
+        if (y < 0)
+            return true;
+        if (y >= CHUNK_HEIGHT)
+            return false;
+
+        int chunkX = worldToChunk(x);
+        int chunkZ = worldToChunk(z);
+        if (!hasChunk || chunkX != cachedX || chunkZ != cachedZ)
+        {
+            blocks = lookup(chunkX, chunkZ);
+            cachedX = chunkX;
+            cachedZ = chunkZ;
+            hasChunk = true;
+        }
+        if (!blocks)
+            return true;
+        return isSolidBlock((*blocks)[x - chunkX * CHUNK_WIDTH][y][z - chunkZ * CHUNK_WIDTH]);
+    }
+
+private:
+    const ChunkLookup &lookup;
+    const ChunkBlocks *blocks = nullptr;
+    int cachedX = 0, cachedZ = 0;
+    bool hasChunk = false;
+};
+
+struct Box
+{
+    float min[3];
+    float max[3];
+};
+
+static Box bodyBox(const PlayerBody &body)
+{
+    const float half = PLAYER_WIDTH * 0.5f;
+    Box box;
+    box.min[0] = body.position[0] - half;
+    box.min[1] = body.position[1];
+    box.min[2] = body.position[2] - half;
+    box.max[0] = body.position[0] + half;
+    box.max[1] = body.position[1] + PLAYER_HEIGHT;
+    box.max[2] = body.position[2] + half;
+    return box;
+}
+
+// how far the box can move along axis (signed amount) before it hits a
+// solid block. the broadphase is the range of blocks the swept box covers
+static float sweepAxis(BlockReader &reader, const Box &box, int axis, float amount)
+{
+    if (amount == 0.0f)
+        return 0.0f;
+
+    int from[3], to[3];
+    for (int i = 0; i < 3; i++)
+    {
+        float low = box.min[i] + SKIN;
+        float high = box.max[i] - SKIN;
+        if (i == axis)
+        {
+            low = amount > 0.0f ? box.max[i] : box.min[i] + amount;
+            high = amount > 0.0f ? box.max[i] + amount : box.min[i];
+        }
+        from[i] = (int)std::floor(low);
+        to[i] = (int)std::floor(high);
+    }
+
+    float allowed = amount;
+    for (int x = from[0]; x <= to[0]; x++)
+    {
+        for (int y = from[1]; y <= to[1]; y++)
+        {
+            for (int z = from[2]; z <= to[2]; z++)
+            {
+                if (!reader.isSolid(x, y, z))
+                    continue;
+
+                int cell[3] = {x, y, z};
+                if (amount > 0.0f)
+                    allowed = std::min(allowed, cell[axis] - box.max[axis] - SKIN);
+                else
+                    allowed = std::max(allowed, cell[axis] + 1 - box.min[axis] + SKIN);
+            }
+        }
+    }
+
+    // already touching, dont get pulled into the block
+    if ((amount > 0.0f && allowed < 0.0f) || (amount < 0.0f && allowed > 0.0f))
+        allowed = 0.0f;
+    return allowed;
+}
+
+void stepPlayer(PlayerBody &body, const PlayerInput &input, const ChunkLookup &lookup)
+{
+    BlockReader reader(lookup);
+    const float dt = PHYSICS_STEP;
+
+    body.flying = input.flying;
+    float speed = body.flying ? FLY_SPEED : WALK_SPEED;
+    body.velocity[0] = input.moveX * speed;
+    body.velocity[2] = input.moveZ * speed;
+
+    if (body.flying)
+    {
+        body.velocity[1] = input.jump ? FLY_SPEED : input.descend ? -FLY_SPEED : 0.0f;
+    }
+    else
+    {
+        if (input.jump && body.onGround)
+            body.velocity[1] = JUMP_SPEED;
+        body.velocity[1] = std::max(body.velocity[1] - GRAVITY * dt, -TERMINAL_SPEED);
+    }
+
+    // y first, so walking off a ledge and landing resolve before sliding
+    static const int axes[3] = {1, 0, 2};
+    body.onGround = false;
+    for (int axis : axes)
+    {
+        float wanted = body.velocity[axis] * dt;
+        float moved = sweepAxis(reader, bodyBox(body), axis, wanted);
+        body.position[axis] += moved;
+
+        if (moved != wanted)
+        {
+            if (axis == 1 && wanted < 0.0f)
+                body.onGround = true;
+            body.velocity[axis] = 0.0f;
+        }
+    }
+}
+
+void unstuckPlayer(PlayerBody &body, const ChunkLookup &lookup)
+{
+    BlockReader reader(lookup);
+    for (int tries = 0; tries < CHUNK_HEIGHT + 4; tries++)
+    {
+        Box box = bodyBox(body);
+        bool blocked = false;
+        for (int x = (int)std::floor(box.min[0]); x <= (int)std::floor(box.max[0]) && !blocked; x++)
+            for (int y = (int)std::floor(box.min[1]); y <= (int)std::floor(box.max[1]) && !blocked; y++)
+                for (int z = (int)std::floor(box.min[2]); z <= (int)std::floor(box.max[2]) && !blocked; z++)
+                    blocked = y >= 0 && reader.isSolid(x, y, z);
+        if (!blocked)
+            return;
+        body.position[1] = std::floor(body.position[1]) + 1.0f;
+        body.velocity[1] = 0.0f;
+    }
+}
+
+bool playerOverlapsBlock(const PlayerBody &body, int x, int y, int z)
+{
+    Box box = bodyBox(body);
+    return x + 1 > box.min[0] && x < box.max[0] &&
+           y + 1 > box.min[1] && y < box.max[1] &&
+           z + 1 > box.min[2] && z < box.max[2];
+}
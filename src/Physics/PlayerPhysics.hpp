@@ -0,0 +1,47 @@
+#pragma once
+#include "World/Raycast.hpp" // ChunkLookup
+
+// player box, in blocks. position is the middle of the feet
+const float PLAYER_WIDTH = 0.6f;
+const float PLAYER_HEIGHT = 1.8f;
+const float PLAYER_EYE_HEIGHT = 1.62f;
+
+// the simulation always advances in steps of this size, whatever the frame
+// rate, so jumps and falls come out the same at 20 and at 200 fps
+const float PHYSICS_STEP = 1.0f / 60.0f;
+
+struct PlayerInput
+{
+    // wanted horizontal direction in world space, length 0..1
+    float moveX = 0.0f;
+    float moveZ = 0.0f;
+
+    // walking: jump. flying: up / down
+    bool jump = false;
+    bool descend = false;
+
+    // switches the body between walking and flying at the next step
+    bool flying = false;
+};
+
+struct PlayerBody
+{
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    float velocity[3] = {0.0f, 0.0f, 0.0f};
+    bool onGround = false;
+    bool flying = false;
+};
+
+// one fixed step: applies input and gravity, then moves the box one axis at
+// a time (y, x, z), each clipped against the solid blocks it would sweep
+// through. only the blocks overlapped by the swept box are looked at.
+// unloaded chunks count as solid, so nobody falls through a chunk that
+// isnt there yet
+void stepPlayer(PlayerBody &body, const PlayerInput &input, const ChunkLookup &lookup);
+
+// pushes the body up until its box is out of any solid block, for spawning
+// and after the world changed under it
+void unstuckPlayer(PlayerBody &body, const ChunkLookup &lookup);
+
+// true if the block overlaps the body's box (dont place blocks in it)
+bool playerOverlapsBlock(const PlayerBody &body, int x, int y, int z);
@@ -0,0 +1,80 @@
+#include "Profiler/FrameStats.hpp"
+
+#include <algorithm>
+
+const char *framePhaseName(FramePhase phase)
+{
+    static const char *names[PHASE_COUNT] = {
+        "processInput",
+        "glfwPollEvents",
+        "setMatrix",
+        "updatePlayerChunkPos",
+        "renderChunks",
+        "nuklear",
+        "restoreState",
+        "glfwSwapBuffers",
+    };
+    return names[phase];
+}
+
+void FrameStats::endFrame()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (!started)
+    {
+        // nothing to measure the first frame against
+        started = true;
+        lastFrameEnd = now;
+        std::fill(currentPhases, currentPhases + PHASE_COUNT, 0.0f);
+        return;
+    }
+
+    float ms = std::chrono::duration<float, std::milli>(now - lastFrameEnd).count();
+    lastFrameEnd = now;
+
+    frameTimes[head] = ms;
+    std::copy(currentPhases, currentPhases + PHASE_COUNT, phaseTimes[head]);
+    std::fill(currentPhases, currentPhases + PHASE_COUNT, 0.0f);
+
+    head = (head + 1) % FRAME_HISTORY;
+    count = std::min(count + 1, FRAME_HISTORY);
+
+    if (ms > hitchThresholdMs)
+        hitchesTotal++;
+}
+
+FrameStats::Summary FrameStats::summarize() const
+{
+    Summary s;
+    s.frames = count;
+    if (count == 0)
+        return s;
+
+    float sorted[FRAME_HISTORY];
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        int slot = (head + FRAME_HISTORY - count + i) % FRAME_HISTORY;
+        sorted[i] = frameTimes[slot];
+        sum += sorted[i];
+        if (sorted[i] > hitchThresholdMs)
+            s.hitches++;
+
+        for (int p = 0; p < PHASE_COUNT; p++)
+        {
+            s.phaseAvgMs[p] += phaseTimes[slot][p];
+            s.phaseMaxMs[p] = std::max(s.phaseMaxMs[p], phaseTimes[slot][p]);
+        }
+    }
+    for (int p = 0; p < PHASE_COUNT; p++)
+        s.phaseAvgMs[p] /= count;
+
+    // nearest rank percentiles
+    std::sort(sorted, sorted + count);
+    s.avgMs = sum / count;
+    s.p50Ms = sorted[(count - 1) * 50 / 100];
+    s.p95Ms = sorted[(count - 1) * 95 / 100];
+    s.p99Ms = sorted[(count - 1) * 99 / 100];
+    s.maxMs = sorted[count - 1];
+    return s;
+}
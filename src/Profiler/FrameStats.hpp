@@ -0,0 +1,92 @@
+#pragma once
+#include <chrono>
+#include "Profiler/Profiler.hpp"
+
+// the parts of a frame that get timed separately
+enum FramePhase
+{
+    PHASE_INPUT,
+    PHASE_EVENTS,
+    PHASE_MATRIX,
+    PHASE_CHUNK_UPDATE,
+    PHASE_RENDER_CHUNKS,
+    PHASE_UI,
+    PHASE_RESTORE,
+    PHASE_SWAP,
+    PHASE_COUNT,
+};
+
+const char *framePhaseName(FramePhase phase);
+
+// rolling window of the last FRAME_HISTORY frame times (plus the per-phase
+// times of each of those frames). single threaded, owned by the render loop
+class FrameStats
+{
+public:
+    static const int FRAME_HISTORY = 240;
+
+    struct Summary
+    {
+        int frames = 0;
+        float avgMs = 0.0f;
+        float p50Ms = 0.0f;
+        float p95Ms = 0.0f;
+        float p99Ms = 0.0f;
+        float maxMs = 0.0f;
+        int hitches = 0; // frames over the hitch threshold in the window
+        float phaseAvgMs[PHASE_COUNT] = {};
+        float phaseMaxMs[PHASE_COUNT] = {};
+    };
+
+    // frames longer than this count as hitches
+    float hitchThresholdMs = 33.3f;
+
+    // adds time to a phase of the frame in progress
+    void addPhaseTime(FramePhase phase, float ms) { currentPhases[phase] += ms; }
+
+    // closes the frame in progress, its length is the time since the last endFrame
+    void endFrame();
+
+    Summary summarize() const;
+
+    // frame times oldest -> newest, i in 0..frameCount()-1
+    int frameCount() const { return count; }
+    float frameMs(int i) const { return frameTimes[(head + FRAME_HISTORY - count + i) % FRAME_HISTORY]; }
+
+    // hitches since start, not just in the window
+    int totalHitches() const { return hitchesTotal; }
+
+private:
+    float frameTimes[FRAME_HISTORY] = {};
+    float phaseTimes[FRAME_HISTORY][PHASE_COUNT] = {};
+    float currentPhases[PHASE_COUNT] = {};
+    int head = 0; // next slot to write
+    int count = 0;
+    int hitchesTotal = 0;
+
+    bool started = false;
+    std::chrono::steady_clock::time_point lastFrameEnd;
+};
+
+// times a scope into one phase of the frame, and into the trace when capturing
+class PhaseTimer
+{
+public:
+    PhaseTimer(FrameStats &stats, FramePhase phase)
+        : stats(stats), phase(phase), start(std::chrono::steady_clock::now()) {}
+
+    ~PhaseTimer()
+    {
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        stats.addPhaseTime(phase, elapsed.count());
+    }
+
+private:
+    FrameStats &stats;
+    FramePhase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define FRAME_PHASE(stats, phase)                                               \
+    PhaseTimer PROFILE_CONCAT(phaseTimer, __LINE__)(stats, phase);              \
+    PROFILE_SCOPE(framePhaseName(phase))
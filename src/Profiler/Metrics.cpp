@@ -0,0 +1,76 @@
+#include "Profiler/Metrics.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+static std::atomic<int64_t> values[METRIC_COUNT];
+
+void Metrics::add(Metric metric, int64_t amount)
+{
+    values[metric].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Metrics::set(Metric metric, int64_t value)
+{
+    values[metric].store(value, std::memory_order_relaxed);
+}
+
+int64_t Metrics::get(Metric metric)
+{
+    return values[metric].load(std::memory_order_relaxed);
+}
+
+const char *Metrics::name(Metric metric)
+{
+    static const char *names[METRIC_COUNT] = {
+        "chunks_queued",
+        "chunks_generating",
+        "chunks_meshed",
+        "chunks_resident",
+        "block_bytes",
+        "vertex_bytes",
+        "gpu_vertex_bytes",
+        "dirty_chunks",
+        "edit_latency_us",
+        "scheduled_ticks",
+        "lod_chunks",
+        "lod_gpu_vertex_bytes",
+        "cull_tested",
+        "frustum_culled",
+        "occlusion_culled",
+        "graph_culled",
+        "cull_us",
+        "chunks_generated_total",
+        "chunks_cancelled_total",
+        "chunks_unloaded_total",
+        "chunks_loaded_from_disk_total",
+        "chunks_saved_total",
+        "autosave_batches_total",
+        "scheduled_ticks_run_total",
+        "random_ticks_total",
+    };
+    return names[metric];
+}
+
+bool Metrics::isCounter(Metric metric)
+{
+    return metric >= METRIC_CHUNKS_GENERATED;
+}
+
+bool Metrics::dumpToFile(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return false;
+
+    fprintf(f, "{\n");
+    for (int i = 0; i < METRIC_COUNT; i++)
+    {
+        Metric metric = (Metric)i;
+        fprintf(f, "  \"%s\": {\"type\": \"%s\", \"value\": %lld}%s\n", name(metric),
+                isCounter(metric) ? "counter" : "gauge", (long long)get(metric), i + 1 < METRIC_COUNT ? "," : "");
+    }
+    fprintf(f, "}\n");
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+
+// process wide counters (only go up) and gauges (current value), updated
+// with relaxed atomics from any thread, so the chunk pipeline can report
+// without locks. read them in the debug menu or dump them to a file
+enum Metric
+{
+    // gauges: chunks currently in each pipeline state
+    METRIC_CHUNKS_QUEUED,
+    METRIC_CHUNKS_GENERATING,
+    METRIC_CHUNKS_MESHED, // meshed, not uploaded yet
+    METRIC_CHUNKS_RESIDENT, // uploaded to the GPU
+
+    // gauges: bytes held by chunks
+    METRIC_BLOCK_BYTES, // blocks + light
+    METRIC_VERTEX_BYTES, // CPU side vertex arrays
+    METRIC_GPU_VERTEX_BYTES,
+
+    // gauge: edited chunks not on disk yet
+    METRIC_DIRTY_CHUNKS,
+
+    // gauge: microseconds from the last block edit to its mesh being uploaded
+    METRIC_EDIT_LATENCY_US,
+
+    // gauge: block ticks scheduled, not run yet
+    METRIC_SCHEDULED_TICKS,
+
+    // gauges: distant chunks drawn as coarse meshes only
+    METRIC_LOD_CHUNKS, // on the GPU
+    METRIC_LOD_GPU_VERTEX_BYTES,
+
+    // gauges: the culling of the last frame, sections and LOD tiles
+    METRIC_CULL_TESTED,
+    METRIC_FRUSTUM_CULLED,
+    METRIC_OCCLUSION_CULLED,
+    METRIC_GRAPH_CULLED, // not reachable in the section graph
+    METRIC_CULL_US,
+
+    // counters
+    METRIC_CHUNKS_GENERATED,
+    METRIC_CHUNKS_CANCELLED, // unloaded before their job started
+    METRIC_CHUNKS_UNLOADED,
+    METRIC_CHUNKS_LOADED_FROM_DISK,
+    METRIC_CHUNKS_SAVED,
+    METRIC_AUTOSAVE_BATCHES,
+    METRIC_SCHEDULED_TICKS_RUN,
+    METRIC_RANDOM_TICKS, // random ticks that hit a ticked block
+
+    METRIC_COUNT,
+};
+
+class Metrics
+{
+public:
+    static void add(Metric metric, int64_t amount);
+    static void increment(Metric metric) { add(metric, 1); }
+    static void decrement(Metric metric) { add(metric, -1); }
+    static void set(Metric metric, int64_t value);
+    static int64_t get(Metric metric);
+
+    static const char *name(Metric metric);
+    static bool isCounter(Metric metric);
+
+    // writes every metric as json, returns false if the file couldnt be opened
+    static bool dumpToFile(const char *path);
+};
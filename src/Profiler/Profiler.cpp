@@ -0,0 +1,176 @@
+#include "Profiler/Profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent
+{
+    const char *name;
+    uint64_t start;
+    uint64_t duration;
+};
+
+// one per thread that ever recorded something. the mutex is only contended
+// while the trace gets written, so recording stays cheap
+struct ThreadBuffer
+{
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::string name;
+    int tid;
+};
+
+static std::atomic<bool> capturing{false};
+static std::atomic<int> framesLeft{0};
+static std::string capturePath;
+static uint64_t lastFrameMark = 0;
+
+// every buffer ever created. the trace is written from here after the
+// capture, when a thread that recorded into one may be gone (the io
+// thread of a RegionStore closed by a world change), so they outlive their
+// threads
+static std::mutex registryMutex;
+static std::vector<std::shared_ptr<ThreadBuffer>> registry;
+static int nextTid = 1;
+
+static ThreadBuffer &threadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<ThreadBuffer>();
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->tid = nextTid++;
+
+        // forget threads that exited with nothing left to write
+        for (auto it = registry.begin(); it != registry.end();)
+        {
+            if (it->use_count() == 1 && (*it)->events.empty())
+                it = registry.erase(it);
+            else
+                it++;
+        }
+        registry.push_back(buffer);
+    }
+    return *buffer;
+}
+
+uint64_t Profiler::nowMicros()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+bool Profiler::isCapturing()
+{
+    return capturing.load(std::memory_order_relaxed);
+}
+
+int Profiler::captureFramesLeft()
+{
+    return framesLeft.load(std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char *name)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void Profiler::record(const char *name, uint64_t startMicros, uint64_t endMicros)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({name, startMicros, endMicros - startMicros});
+}
+
+void Profiler::beginCapture(int frameCount, const std::string &path)
+{
+    if (capturing || frameCount <= 0)
+        return;
+
+    {
+        // drop whatever was recorded after the last capture ended, and the
+        // buffers of threads that are gone
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto it = registry.begin(); it != registry.end();)
+        {
+            if (it->use_count() == 1)
+            {
+                it = registry.erase(it);
+                continue;
+            }
+            std::lock_guard<std::mutex> bufferLock((*it)->mutex);
+            (*it)->events.clear();
+            it++;
+        }
+    }
+
+    capturePath = path;
+    lastFrameMark = nowMicros();
+    framesLeft = frameCount;
+    capturing = true;
+}
+
+static void writeTrace(const std::string &path)
+{
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f)
+    {
+        fprintf(stderr, "Profiler: could not open %s for writing\n", path.c_str());
+        return;
+    }
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const std::shared_ptr<ThreadBuffer> &buffer : registry)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        if (buffer->events.empty())
+            continue;
+
+        if (!buffer->name.empty())
+        {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", buffer->tid, buffer->name.c_str());
+            first = false;
+        }
+
+        for (const TraceEvent &e : buffer->events)
+        {
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}",
+                    first ? "" : ",\n", e.name, buffer->tid,
+                    (unsigned long long)e.start, (unsigned long long)e.duration);
+            first = false;
+        }
+        buffer->events.clear();
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    printf("Profiler: trace written to %s\n", path.c_str());
+}
+
+void Profiler::frameMark()
+{
+    if (!capturing)
+        return;
+
+    uint64_t now = nowMicros();
+    record("frame", lastFrameMark, now);
+    lastFrameMark = now;
+
+    if (--framesLeft <= 0)
+    {
+        capturing = false;
+        writeTrace(capturePath);
+    }
+}
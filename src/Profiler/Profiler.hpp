@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// scoped timers that record into per-thread buffers while a capture is
+// running, then get written out as Chrome trace-event JSON (chrome://tracing
+// or ui.perfetto.dev). outside a capture a scope costs one relaxed atomic load.
+//
+// building with -DMINECRAFT_ENABLE_PROFILER=OFF (MINECRAFT_PROFILER=0) turns
+// every PROFILE_* macro into nothing.
+#ifndef MINECRAFT_PROFILER
+#define MINECRAFT_PROFILER 1
+#endif
+
+class Profiler
+{
+public:
+    // record the next frameCount frames, then write them to path
+    static void beginCapture(int frameCount, const std::string &path);
+    static bool isCapturing();
+
+    // frames left in the running capture (0 when not capturing)
+    static int captureFramesLeft();
+
+    // marks the end of a frame, call once per frame from the render thread
+    static void frameMark();
+
+    // name shown for the calling thread in the trace
+    static void setThreadName(const char *name);
+
+    // microseconds since the profiler was first used
+    static uint64_t nowMicros();
+
+    // adds a finished span to the calling thread's buffer
+    static void record(const char *name, uint64_t startMicros, uint64_t endMicros);
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name) : name(name), active(Profiler::isCapturing())
+    {
+        if (active)
+            start = Profiler::nowMicros();
+    }
+
+    ~ProfileScope()
+    {
+        if (active)
+            Profiler::record(name, start, Profiler::nowMicros());
+    }
+
+private:
+    const char *name; // has to be a string literal (stored, not copied)
+    bool active;
+    uint64_t start = 0;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if MINECRAFT_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::setThreadName(name)
+#define PROFILE_FRAME() Profiler::frameMark()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
@@ -0,0 +1,291 @@
+#include "Render/OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// w below this is treated as behind the camera
+static const float NEAR_W = 0.05f;
+
+// corners of a box, bit 0 x, bit 1 y, bit 2 z set for max
+static void boxCorner(const float min[3], const float max[3], int corner, float out[3])
+{
+    out[0] = corner & 1 ? max[0] : min[0];
+    out[1] = corner & 2 ? max[1] : min[1];
+    out[2] = corner & 4 ? max[2] : min[2];
+}
+
+// corners of a side of the box, counter clockwise seen from outside: the
+// two other axes in cyclic order span the side, backwards for the
+// negative one
+static const int quadSteps[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+OcclusionCuller::OcclusionCuller(int width, int height) : width(width), height(height)
+{
+    int levelWidth = width, levelHeight = height;
+    while (true)
+    {
+        levels.push_back(Level{levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.0f)});
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        levelWidth = std::max(1, (levelWidth + 1) / 2);
+        levelHeight = std::max(1, (levelHeight + 1) / 2);
+    }
+    for (int i = 0; i < 16; i++)
+        matrix[i] = 0.0f;
+    stats = Stats{0, 0, 0, 0};
+}
+
+void OcclusionCuller::beginFrame(const float viewProjection[16])
+{
+    for (int i = 0; i < 16; i++)
+        matrix[i] = viewProjection[i];
+    std::fill(levels[0].depth.begin(), levels[0].depth.end(), 1.0f);
+    pyramidBuilt = false;
+    stats = Stats{0, 0, 0, 0};
+}
+
+bool OcclusionCuller::project(float x, float y, float z, ScreenVertex &out) const
+{
+    const float *m = matrix;
+    float clipX = m[0] * x + m[4] * y + m[8] * z + m[12];
+    float clipY = m[1] * x + m[5] * y + m[9] * z + m[13];
+    float clipZ = m[2] * x + m[6] * y + m[10] * z + m[14];
+    float clipW = m[3] * x + m[7] * y + m[11] * z + m[15];
+    if (clipW < NEAR_W)
+        return false;
+
+    out.x = (clipX / clipW * 0.5f + 0.5f) * width;
+    out.y = (clipY / clipW * 0.5f + 0.5f) * height;
+    out.z = clipZ / clipW;
+    return true;
+}
+
+// half space rasterizer sampled at texel centers, front facing (counter
+// clockwise on screen) triangles only. the edge functions and NDC z are
+// linear in screen space, so each row solves for the span inside all three
+// edges and steps z along it
+void OcclusionCuller::rasterizeTriangle(const ScreenVertex &a, const ScreenVertex &b, const ScreenVertex &c)
+{
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area < 1e-6f)
+        return;
+
+    int fromX = std::max(0, (int)std::floor(std::min(a.x, std::min(b.x, c.x))));
+    int toX = std::min(width - 1, (int)std::ceil(std::max(a.x, std::max(b.x, c.x))));
+    int fromY = std::max(0, (int)std::floor(std::min(a.y, std::min(b.y, c.y))));
+    int toY = std::min(height - 1, (int)std::ceil(std::max(a.y, std::max(b.y, c.y))));
+    if (fromX > toX || fromY > toY)
+        return;
+
+    // each edge function is positive on the inside, zero at the vertex
+    // opposite of it times the area: value at the first texel center, steps
+    // in x and y
+    const ScreenVertex *from[3] = {&b, &c, &a}, *to[3] = {&c, &a, &b};
+    float edge[3], stepX[3], stepY[3];
+    float px = fromX + 0.5f, py = fromY + 0.5f;
+    for (int i = 0; i < 3; i++)
+    {
+        stepX[i] = from[i]->y - to[i]->y;
+        stepY[i] = to[i]->x - from[i]->x;
+        edge[i] = (from[i]->x - px) * (to[i]->y - py) - (from[i]->y - py) * (to[i]->x - px);
+    }
+    float inverseArea = 1.0f / area;
+    float zStepX = (stepX[0] * a.z + stepX[1] * b.z + stepX[2] * c.z) * inverseArea;
+    float zStepY = (stepY[0] * a.z + stepY[1] * b.z + stepY[2] * c.z) * inverseArea;
+    float zFirst = (edge[0] * a.z + edge[1] * b.z + edge[2] * c.z) * inverseArea;
+
+    std::vector<float> &depth = levels[0].depth;
+    for (int y = fromY; y <= toY; y++)
+    {
+        // clamped before the cast, nearly flat edges step very little in x
+        float spanFrom = (float)fromX, spanTo = (float)toX;
+        for (int i = 0; i < 3; i++)
+        {
+            if (stepX[i] > 0.0f)
+                spanFrom = std::max(spanFrom, fromX + std::ceil(-edge[i] / stepX[i]));
+            else if (stepX[i] < 0.0f)
+                spanTo = std::min(spanTo, fromX + std::floor(edge[i] / -stepX[i]));
+            else if (edge[i] < 0.0f)
+                spanTo = fromX - 1.0f;
+        }
+
+        float *row = &depth[y * width];
+        float zRow = zFirst + (y - fromY) * zStepY;
+        for (int x = (int)spanFrom, lastX = (int)spanTo; x <= lastX; x++)
+        {
+            float z = zRow + (x - fromX) * zStepX;
+            if (z < row[x])
+                row[x] = z;
+        }
+
+        for (int i = 0; i < 3; i++)
+            edge[i] += stepY[i];
+    }
+}
+
+void OcclusionCuller::addBoxFace(const float min[3], const float max[3], int axis, bool positive)
+{
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    ScreenVertex corners[4];
+    for (int corner = 0; corner < 4; corner++)
+    {
+        const int *step = quadSteps[positive ? corner : (4 - corner) % 4];
+        float point[3];
+        point[axis] = positive ? max[axis] : min[axis];
+        point[u] = step[0] ? max[u] : min[u];
+        point[v] = step[1] ? max[v] : min[v];
+        // clipping is not worth it for an occluder, just leave it out
+        if (!project(point[0], point[1], point[2], corners[corner]))
+            return;
+    }
+
+    rasterizeTriangle(corners[0], corners[1], corners[2]);
+    rasterizeTriangle(corners[0], corners[2], corners[3]);
+    stats.occluders++;
+}
+
+void OcclusionCuller::addOccluder(const float min[3], const float max[3])
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        addBoxFace(min, max, axis, false);
+        addBoxFace(min, max, axis, true);
+    }
+}
+
+void OcclusionCuller::addOccluderHeightfield(float originX, float originZ, float cellSize, int cellsWide, const int *heights)
+{
+    static const int sides[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    for (int x = 0; x < cellsWide; x++)
+    {
+        for (int z = 0; z < cellsWide; z++)
+        {
+            int height = heights[x * cellsWide + z];
+            if (height <= 0)
+                continue;
+            float min[3] = {originX + x * cellSize, 0.0f, originZ + z * cellSize};
+            float max[3] = {min[0] + cellSize, (float)height, min[2] + cellSize};
+            addBoxFace(min, max, 1, true);
+
+            // walls down to the next cell, or the ground past the grid
+            for (const int *side : sides)
+            {
+                int nextX = x + side[0], nextZ = z + side[1];
+                int next = 0;
+                if (nextX >= 0 && nextX < cellsWide && nextZ >= 0 && nextZ < cellsWide)
+                    next = heights[nextX * cellsWide + nextZ];
+                if (next >= height)
+                    continue;
+                float wallMin[3] = {min[0], (float)std::max(next, 0), min[2]};
+                addBoxFace(wallMin, max, side[0] != 0 ? 0 : 2, side[0] + side[1] > 0);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::buildPyramid()
+{
+    for (size_t i = 1; i < levels.size(); i++)
+    {
+        const Level &below = levels[i - 1];
+        Level &level = levels[i];
+        for (int y = 0; y < level.height; y++)
+        {
+            for (int x = 0; x < level.width; x++)
+            {
+                // odd sizes: the last texel of a row / column covers only one below
+                int x0 = 2 * x, x1 = std::min(2 * x + 1, below.width - 1);
+                int y0 = 2 * y, y1 = std::min(2 * y + 1, below.height - 1);
+                level.depth[y * level.width + x] = std::max(std::max(below.depth[y0 * below.width + x0], below.depth[y0 * below.width + x1]),
+                                                            std::max(below.depth[y1 * below.width + x0], below.depth[y1 * below.width + x1]));
+            }
+        }
+    }
+    pyramidBuilt = true;
+}
+
+bool OcclusionCuller::isVisible(const float min[3], const float max[3])
+{
+    if (!pyramidBuilt)
+        buildPyramid();
+    stats.tested++;
+
+    float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f, nearest = 1e30f;
+    const float *m = matrix;
+    bool allLeft = true, allRight = true, allBelow = true, allAbove = true, allFar = true;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        float point[3];
+        boxCorner(min, max, corner, point);
+
+        // the view volume test on clip coordinates works for corners behind
+        // the camera too
+        float clipX = m[0] * point[0] + m[4] * point[1] + m[8] * point[2] + m[12];
+        float clipY = m[1] * point[0] + m[5] * point[1] + m[9] * point[2] + m[13];
+        float clipZ = m[2] * point[0] + m[6] * point[1] + m[10] * point[2] + m[14];
+        float clipW = m[3] * point[0] + m[7] * point[1] + m[11] * point[2] + m[15];
+        allLeft &= clipX < -clipW;
+        allRight &= clipX > clipW;
+        allBelow &= clipY < -clipW;
+        allAbove &= clipY > clipW;
+        allFar &= clipZ > clipW;
+
+        if (clipW < NEAR_W)
+        {
+            nearest = -1e30f; // reaches the camera, cant be hidden
+            continue;
+        }
+        float x = (clipX / clipW * 0.5f + 0.5f) * width;
+        float y = (clipY / clipW * 0.5f + 0.5f) * height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, clipZ / clipW);
+    }
+    if (allLeft || allRight || allBelow || allAbove || allFar)
+    {
+        stats.frustumCulled++;
+        return false;
+    }
+    if (nearest < -1.0f)
+        return true;
+
+    // the texels the rectangle touches, on the level where they are 2x2 at most
+    int fromX = std::max(0, (int)std::floor(minX));
+    int toX = std::min(width - 1, (int)std::floor(maxX));
+    int fromY = std::max(0, (int)std::floor(minY));
+    int toY = std::min(height - 1, (int)std::floor(maxY));
+    if (fromX > toX || fromY > toY)
+    {
+        stats.frustumCulled++;
+        return false;
+    }
+    size_t level = 0;
+    while (level + 1 < levels.size() && (toX - fromX > 1 || toY - fromY > 1))
+    {
+        fromX >>= 1;
+        toX >>= 1;
+        fromY >>= 1;
+        toY >>= 1;
+        level++;
+    }
+
+    const Level &hiZ = levels[level];
+    for (int y = fromY; y <= toY; y++)
+    {
+        for (int x = fromX; x <= toX; x++)
+        {
+            if (nearest <= hiZ.depth[y * hiZ.width + x])
+                return true;
+        }
+    }
+    stats.occlusionCulled++;
+    return false;
+}
+
+float OcclusionCuller::getDepth(int level, int x, int y) const
+{
+    const Level &hiZ = levels[std::min((size_t)level, levels.size() - 1)];
+    return hiZ.depth[y * hiZ.width + x];
+}
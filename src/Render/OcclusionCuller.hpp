@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+
+// boxes hidden behind the terrain, on the CPU and without GL, so it also
+// runs in headless tools.
+//
+// every frame the occluders (the surface of things known to be completely
+// solid, see SectionMesh::occluderHeights) are rasterized into a coarse
+// depth buffer, only the faces the camera looks at from outside (behind
+// those is solid or hidden by it, from inside anything could be). then a
+// hierarchical-Z pyramid is built on it, each level keeping the
+// farthest depth of 2x2 texels of the one below. a box is hidden when its
+// nearest corner is behind the farthest depth of every texel its screen
+// rectangle touches, at the level where that rectangle is about 2x2
+// texels. boxes outside the view are culled on the way.
+//
+// anything the test cant be sure about (a corner behind the camera) counts
+// as visible. depths are sampled at texel centers, so a gap thinner than a
+// texel between two occluders may hide what is behind it.
+class OcclusionCuller
+{
+public:
+    struct Stats
+    {
+        int occluders;       // quads rasterized
+        int tested;          // boxes tested
+        int frustumCulled;   // of those, outside the view
+        int occlusionCulled; // of those, hidden behind the occluders
+    };
+
+    OcclusionCuller(int width = 256, int height = 128);
+
+    // starts a frame. viewProjection is column major (glm::value_ptr of
+    // projection * view)
+    void beginFrame(const float viewProjection[16]);
+
+    // the occluders, world space, all added before the first test.
+    //
+    // a box that is solid all the way through
+    void addOccluder(const float min[3], const float max[3]);
+
+    // columns solid from y = 0 up to heights[x * cellsWide + z] on a grid
+    // of cellsWide x cellsWide cells of cellSize, from (originX, originZ).
+    // only the outside: cell tops, and walls where the next cell is lower
+    // or the grid ends
+    void addOccluderHeightfield(float originX, float originZ, float cellSize, int cellsWide, const int *heights);
+
+    bool isVisible(const float min[3], const float max[3]);
+
+    const Stats &getStats() const { return stats; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // level 0 is the rasterized depth buffer, NDC z, 1 where nothing is.
+    // the levels above it are built by the first test of the frame
+    float getDepth(int level, int x, int y) const;
+
+private:
+    struct ScreenVertex
+    {
+        float x, y, z; // pixels, NDC z
+    };
+
+    struct Level
+    {
+        int width, height;
+        std::vector<float> depth;
+    };
+
+    const int width, height;
+    float matrix[16];
+    std::vector<Level> levels;
+    bool pyramidBuilt = false;
+    Stats stats;
+
+    // false if the point is too close to or behind the camera
+    bool project(float x, float y, float z, ScreenVertex &out) const;
+    void addBoxFace(const float min[3], const float max[3], int axis, bool positive);
+    void rasterizeTriangle(const ScreenVertex &a, const ScreenVertex &b, const ScreenVertex &c);
+    void buildPyramid();
+};
@@ -0,0 +1,103 @@
+#include "Render/SectionGraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// the sides in FaceDirection order, as steps in chunks / sections
+static const int sideSteps[6][3] = {
+    {0, 1, 0},  // TOP
+    {0, -1, 0}, // BOTTOM
+    {0, 0, 1},  // FRONT
+    {0, 0, -1}, // BACK
+    {-1, 0, 0}, // LEFT
+    {1, 0, 0},  // RIGHT
+};
+
+// the pairs are next to each other
+static int oppositeSide(int side)
+{
+    return side ^ 1;
+}
+
+int SectionGraph::nodeIndex(int chunkX, int section, int chunkZ) const
+{
+    int side = 2 * radius + 1;
+    return ((chunkX - centerX + radius) * side + (chunkZ - centerZ + radius)) * (SECTION_COUNT + 1) + section;
+}
+
+void SectionGraph::update(const float camera[3], const float look[3], int radius, const ConnectionsFn &connections)
+{
+    stats = Stats{0};
+    if (camera[1] < 0.0f)
+    {
+        // under the world, nothing to walk through
+        this->radius = -1;
+        return;
+    }
+    int cameraX = worldToChunk((int)std::floor(camera[0]));
+    int cameraZ = worldToChunk((int)std::floor(camera[2]));
+    int cameraSection = std::min((int)camera[1] / SECTION_HEIGHT, SECTION_COUNT);
+
+    centerX = cameraX;
+    centerZ = cameraZ;
+    this->radius = radius;
+    int side = 2 * radius + 1;
+    nodes.assign(side * side * (SECTION_COUNT + 1), Node{-1, 0, false});
+
+    int start = nodeIndex(cameraX, cameraSection, cameraZ);
+    nodes[start].visited = true;
+    queue.clear();
+    queue.push_back(start);
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        int index = queue[head];
+        const Node node = nodes[index];
+        int section = index % (SECTION_COUNT + 1);
+        int chunkZ = index / (SECTION_COUNT + 1) % side - radius + centerZ;
+        int chunkX = index / (SECTION_COUNT + 1) / side - radius + centerX;
+        stats.visited++;
+
+        // the sky and sections not meshed yet connect everything
+        const uint8_t *connected = section < SECTION_COUNT ? connections(chunkX, section, chunkZ) : nullptr;
+
+        for (int out = 0; out < 6; out++)
+        {
+            if (node.directions & (1u << oppositeSide(out)))
+                continue;
+            if (node.entered >= 0 && connected && !(connected[node.entered] & (1u << out)))
+                continue;
+
+            int nextX = chunkX + sideSteps[out][0];
+            int nextSection = section + sideSteps[out][1];
+            int nextZ = chunkZ + sideSteps[out][2];
+            if (nextSection < 0 || nextSection > SECTION_COUNT || std::abs(nextX - centerX) > radius || std::abs(nextZ - centerZ) > radius)
+                continue;
+            int next = nodeIndex(nextX, nextSection, nextZ);
+            if (nodes[next].visited)
+                continue;
+
+            // the corner of the box furthest along look, behind the camera
+            // means all of it is
+            float corner[3] = {
+                (float)(nextX * CHUNK_WIDTH + (look[0] > 0.0f ? CHUNK_WIDTH : 0)),
+                (float)(nextSection * SECTION_HEIGHT + (look[1] > 0.0f ? SECTION_HEIGHT : 0)),
+                (float)(nextZ * CHUNK_WIDTH + (look[2] > 0.0f ? CHUNK_WIDTH : 0)),
+            };
+            if ((corner[0] - camera[0]) * look[0] + (corner[1] - camera[1]) * look[1] + (corner[2] - camera[2]) * look[2] < 0.0f)
+                continue;
+
+            nodes[next].visited = true;
+            nodes[next].entered = (int8_t)oppositeSide(out);
+            nodes[next].directions = node.directions | (uint8_t)(1u << out);
+            queue.push_back(next);
+        }
+    }
+}
+
+bool SectionGraph::isReachable(int chunkX, int section, int chunkZ) const
+{
+    if (radius < 0 || std::abs(chunkX - centerX) > radius || std::abs(chunkZ - centerZ) > radius)
+        return true;
+    return nodes[nodeIndex(chunkX, section, chunkZ)].visited;
+}
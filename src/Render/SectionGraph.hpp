@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "World/Block.hpp"
+
+// the sections the camera can possibly see through open space, so caves
+// and tunnels dont draw the whole surface above them. no GL, it also runs
+// in headless tools.
+//
+// a walk over the sections from the camera's: into a neighbor through a
+// side only if the section connects the side it was entered from to that
+// one (SectionMesh::faceConnections), never back against a direction the
+// walk already took, and never into a section wholly behind the camera.
+// the layer above the world is open sky, so paths over a hill are found.
+//
+// a section is only visited from the first side it is reached from, so a
+// section seen through two openings can be missed when the first doesnt
+// lead on. sections outside the walked area count as reachable
+class SectionGraph
+{
+public:
+    // for the section (chunkX, section, chunkZ), what
+    // SectionMesh::faceConnections is, or nullptr if it isnt meshed: the
+    // walk goes through those as if they were empty
+    typedef std::function<const uint8_t *(int chunkX, int section, int chunkZ)> ConnectionsFn;
+
+    struct Stats
+    {
+        int visited; // sections the walk reached, sky included
+    };
+
+    // walks from the camera out to radius chunks (chebyshev). look is the
+    // view direction
+    void update(const float camera[3], const float look[3], int radius, const ConnectionsFn &connections);
+
+    bool isReachable(int chunkX, int section, int chunkZ) const;
+
+    const Stats &getStats() const { return stats; }
+
+private:
+    struct Node
+    {
+        int8_t entered;     // side the walk came in through, -1 for the first
+        uint8_t directions; // bit per side the walk stepped out of on the way here
+        bool visited;
+    };
+
+    int centerX = 0, centerZ = 0, radius = -1; // radius -1: nothing walked
+    std::vector<Node> nodes;
+    std::vector<int> queue;
+    Stats stats = Stats{0};
+
+    // SECTION_COUNT + 1 layers, the last one the sky
+    int nodeIndex(int chunkX, int section, int chunkZ) const;
+};
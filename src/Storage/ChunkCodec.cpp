@@ -0,0 +1,399 @@
+#include "Storage/ChunkCodec.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#ifdef MINECRAFT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef MINECRAFT_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+static const size_t BLOCK_COUNT = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_WIDTH;
+
+// one byte per block
+class RawCodec : public ChunkCodec
+{
+public:
+    ChunkCodecId id() const override { return CODEC_RAW; }
+    const char *name() const override { return "raw"; }
+
+    bool encode(const ChunkBlocks &blocks, std::vector<uint8_t> &out) const override
+    {
+        const int *src = &blocks[0][0][0];
+        size_t start = out.size();
+        out.resize(start + BLOCK_COUNT);
+        for (size_t i = 0; i < BLOCK_COUNT; i++)
+        {
+            out[start + i] = (uint8_t)src[i];
+        }
+        return true;
+    }
+
+    bool decode(const uint8_t *data, size_t size, ChunkBlocks &blocks) const override
+    {
+        if (size != BLOCK_COUNT)
+            return false;
+
+        int *dst = &blocks[0][0][0];
+        for (size_t i = 0; i < BLOCK_COUNT; i++)
+        {
+            dst[i] = data[i];
+        }
+        return true;
+    }
+};
+
+// palette layout:
+//   u8 palette size - 1, palette size x u8 block type,
+//   then u64 little endian words, each holding 64 / bits indices (lowest
+//   bits first, an index never spans two words). bits = 0 for one entry
+class PaletteCodec : public ChunkCodec
+{
+public:
+    ChunkCodecId id() const override { return CODEC_PALETTE; }
+    const char *name() const override { return "palette"; }
+
+    bool encode(const ChunkBlocks &blocks, std::vector<uint8_t> &out) const override
+    {
+        const int *src = &blocks[0][0][0];
+
+        // palette in order of first use
+        int paletteIndex[256];
+        memset(paletteIndex, -1, sizeof(paletteIndex));
+        uint8_t palette[256];
+        int paletteSize = 0;
+
+        for (size_t i = 0; i < BLOCK_COUNT; i++)
+        {
+            uint8_t type = (uint8_t)src[i];
+            if (paletteIndex[type] < 0)
+            {
+                paletteIndex[type] = paletteSize;
+                palette[paletteSize++] = type;
+            }
+        }
+
+        int bits = bitsFor(paletteSize);
+        size_t words = wordCountFor(bits);
+
+        size_t start = out.size();
+        out.resize(start + 1 + paletteSize + words * 8);
+        out[start] = (uint8_t)(paletteSize - 1);
+        memcpy(out.data() + start + 1, palette, paletteSize);
+
+        uint8_t *dst = out.data() + start + 1 + paletteSize;
+        size_t i = 0;
+        for (size_t w = 0; w < words; w++)
+        {
+            uint64_t word = 0;
+            for (int shift = 0; shift + bits <= 64 && i < BLOCK_COUNT; shift += bits, i++)
+            {
+                word |= (uint64_t)paletteIndex[(uint8_t)src[i]] << shift;
+            }
+            for (int b = 0; b < 8; b++)
+                dst[w * 8 + b] = (uint8_t)(word >> (8 * b));
+        }
+        return true;
+    }
+
+    bool decode(const uint8_t *data, size_t size, ChunkBlocks &blocks) const override
+    {
+        if (size < 1)
+            return false;
+
+        int paletteSize = data[0] + 1;
+        if (size < 1 + (size_t)paletteSize)
+            return false;
+
+        int palette[256];
+        for (int p = 0; p < paletteSize; p++)
+            palette[p] = data[1 + p];
+
+        int bits = bitsFor(paletteSize);
+        size_t words = wordCountFor(bits);
+        if (size != 1 + paletteSize + words * 8)
+            return false;
+
+        int *dst = &blocks[0][0][0];
+        if (bits == 0)
+        {
+            // single block type
+            for (size_t i = 0; i < BLOCK_COUNT; i++)
+                dst[i] = palette[0];
+            return true;
+        }
+
+        const uint8_t *packed = data + 1 + paletteSize;
+        uint64_t mask = (1ull << bits) - 1;
+        size_t i = 0;
+        for (size_t w = 0; w < words; w++)
+        {
+            uint64_t word = 0;
+            for (int b = 0; b < 8; b++)
+                word |= (uint64_t)packed[w * 8 + b] << (8 * b);
+
+            for (int shift = 0; shift + bits <= 64 && i < BLOCK_COUNT; shift += bits, i++)
+            {
+                int index = (int)((word >> shift) & mask);
+                if (index >= paletteSize)
+                    return false;
+                dst[i] = palette[index];
+            }
+        }
+        return true;
+    }
+
+private:
+    static int bitsFor(int paletteSize)
+    {
+        int bits = 0;
+        while ((1 << bits) < paletteSize)
+            bits++;
+        return bits;
+    }
+
+    static size_t wordCountFor(int bits)
+    {
+        if (bits == 0)
+            return 0;
+        size_t perWord = 64 / bits;
+        return (BLOCK_COUNT + perWord - 1) / perWord;
+    }
+};
+
+// columns are mostly a few long runs (BEDROCK, STONE..., DIRT x3, GRASS, AIR...)
+// layout: for each column x-major then z: (u8 type, u8 length) runs going up y
+// until the column is full. no dependencies, a baseline for the others
+class RleYCodec : public ChunkCodec
+{
+public:
+    ChunkCodecId id() const override { return CODEC_RLE_Y; }
+    const char *name() const override { return "rle-y"; }
+
+    bool encode(const ChunkBlocks &blocks, std::vector<uint8_t> &out) const override
+    {
+        for (int x = 0; x < CHUNK_WIDTH; x++)
+        {
+            for (int z = 0; z < CHUNK_WIDTH; z++)
+            {
+                int y = 0;
+                while (y < CHUNK_HEIGHT)
+                {
+                    int type = blocks[x][y][z];
+                    int length = 1;
+                    while (y + length < CHUNK_HEIGHT && length < 255 && blocks[x][y + length][z] == type)
+                        length++;
+
+                    out.push_back((uint8_t)type);
+                    out.push_back((uint8_t)length);
+                    y += length;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool decode(const uint8_t *data, size_t size, ChunkBlocks &blocks) const override
+    {
+        size_t pos = 0;
+        for (int x = 0; x < CHUNK_WIDTH; x++)
+        {
+            for (int z = 0; z < CHUNK_WIDTH; z++)
+            {
+                int y = 0;
+                while (y < CHUNK_HEIGHT)
+                {
+                    if (pos + 2 > size)
+                        return false;
+
+                    int type = data[pos];
+                    int length = data[pos + 1];
+                    pos += 2;
+                    if (length == 0 || y + length > CHUNK_HEIGHT)
+                        return false;
+
+                    for (int end = y + length; y < end; y++)
+                        blocks[x][y][z] = type;
+                }
+            }
+        }
+        return pos == size;
+    }
+};
+
+// general purpose compressors run over the raw bytes. the raw buffer is the
+// one intermediate copy the other codecs avoid
+#if defined(MINECRAFT_HAVE_ZSTD) || defined(MINECRAFT_HAVE_LZ4)
+static void toRawBytes(const ChunkBlocks &blocks, uint8_t *raw)
+{
+    const int *src = &blocks[0][0][0];
+    for (size_t i = 0; i < BLOCK_COUNT; i++)
+        raw[i] = (uint8_t)src[i];
+}
+
+static void fromRawBytes(const uint8_t *raw, ChunkBlocks &blocks)
+{
+    int *dst = &blocks[0][0][0];
+    for (size_t i = 0; i < BLOCK_COUNT; i++)
+        dst[i] = raw[i];
+}
+#endif
+
+#ifdef MINECRAFT_HAVE_ZSTD
+class ZstdCodec : public ChunkCodec
+{
+public:
+    ChunkCodecId id() const override { return CODEC_ZSTD; }
+    const char *name() const override { return "zstd"; }
+
+    bool encode(const ChunkBlocks &blocks, std::vector<uint8_t> &out) const override
+    {
+        uint8_t raw[BLOCK_COUNT];
+        toRawBytes(blocks, raw);
+
+        size_t start = out.size();
+        out.resize(start + ZSTD_compressBound(BLOCK_COUNT));
+        size_t written = ZSTD_compress(out.data() + start, out.size() - start, raw, BLOCK_COUNT, 3);
+        if (ZSTD_isError(written))
+        {
+            out.resize(start);
+            return false;
+        }
+        out.resize(start + written);
+        return true;
+    }
+
+    bool decode(const uint8_t *data, size_t size, ChunkBlocks &blocks) const override
+    {
+        uint8_t raw[BLOCK_COUNT];
+        size_t read = ZSTD_decompress(raw, BLOCK_COUNT, data, size);
+        if (ZSTD_isError(read) || read != BLOCK_COUNT)
+            return false;
+
+        fromRawBytes(raw, blocks);
+        return true;
+    }
+};
+#endif
+
+#ifdef MINECRAFT_HAVE_LZ4
+class Lz4Codec : public ChunkCodec
+{
+public:
+    ChunkCodecId id() const override { return CODEC_LZ4; }
+    const char *name() const override { return "lz4"; }
+
+    bool encode(const ChunkBlocks &blocks, std::vector<uint8_t> &out) const override
+    {
+        uint8_t raw[BLOCK_COUNT];
+        toRawBytes(blocks, raw);
+
+        size_t start = out.size();
+        out.resize(start + LZ4_compressBound(BLOCK_COUNT));
+        int written = LZ4_compress_default((const char *)raw, (char *)out.data() + start, BLOCK_COUNT, (int)(out.size() - start));
+        if (written <= 0)
+        {
+            out.resize(start);
+            return false;
+        }
+        out.resize(start + written);
+        return true;
+    }
+
+    bool decode(const uint8_t *data, size_t size, ChunkBlocks &blocks) const override
+    {
+        uint8_t raw[BLOCK_COUNT];
+        int read = LZ4_decompress_safe((const char *)data, (char *)raw, (int)size, BLOCK_COUNT);
+        if (read != (int)BLOCK_COUNT)
+            return false;
+
+        fromRawBytes(raw, blocks);
+        return true;
+    }
+};
+#endif
+
+const std::vector<const ChunkCodec *> &chunkCodecs()
+{
+    static const RawCodec raw;
+    static const PaletteCodec palette;
+    static const RleYCodec rleY;
+#ifdef MINECRAFT_HAVE_ZSTD
+    static const ZstdCodec zstd;
+#endif
+#ifdef MINECRAFT_HAVE_LZ4
+    static const Lz4Codec lz4;
+#endif
+
+    static const std::vector<const ChunkCodec *> codecs = {
+        &raw,
+        &palette,
+        &rleY,
+#ifdef MINECRAFT_HAVE_ZSTD
+        &zstd,
+#endif
+#ifdef MINECRAFT_HAVE_LZ4
+        &lz4,
+#endif
+    };
+    return codecs;
+}
+
+const ChunkCodec *findChunkCodec(int id)
+{
+    for (const ChunkCodec *codec : chunkCodecs())
+    {
+        if (codec->id() == id)
+            return codec;
+    }
+    return nullptr;
+}
+
+// savers on any thread read it
+static std::atomic<const ChunkCodec *> defaultCodec{nullptr};
+
+bool setDefaultChunkCodec(int id)
+{
+    const ChunkCodec *codec = findChunkCodec(id);
+    if (!codec)
+        return false;
+
+    defaultCodec = codec;
+    return true;
+}
+
+const ChunkCodec &defaultChunkCodec()
+{
+    const ChunkCodec *codec = defaultCodec.load();
+    return codec ? *codec : *findChunkCodec(CODEC_RLE_Y);
+}
+
+void encodeChunk(const ChunkBlocks &blocks, std::vector<uint8_t> &out, const ChunkCodec &codec)
+{
+    out.clear();
+    out.push_back((uint8_t)codec.id());
+    if (codec.encode(blocks, out))
+        return;
+
+    // a lone id byte would decode as corrupt and the chunk be regenerated
+    const ChunkCodec &fallback = *findChunkCodec(CODEC_PALETTE);
+    out.clear();
+    out.push_back((uint8_t)fallback.id());
+    fallback.encode(blocks, out);
+}
+
+void encodeChunk(const ChunkBlocks &blocks, std::vector<uint8_t> &out)
+{
+    encodeChunk(blocks, out, defaultChunkCodec());
+}
+
+bool decodeChunk(const uint8_t *data, size_t size, ChunkBlocks &blocks)
+{
+    if (size < 1)
+        return false;
+
+    const ChunkCodec *codec = findChunkCodec(data[0]);
+    return codec && codec->decode(data + 1, size - 1, blocks);
+}
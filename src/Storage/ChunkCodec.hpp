@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "World/Block.hpp"
+
+// on-disk encoding of a chunk's blocks. the first byte of every payload is
+// the codec id, so payloads of every codec ever used stay readable
+enum ChunkCodecId
+{
+    CODEC_RAW = 0,     // one byte per block, [x][y][z] order
+    CODEC_PALETTE = 1, // palette of the block types used + bit-packed palette indices
+    CODEC_RLE_Y = 2,   // per column (x, z) runs of (type, length) going up y
+    CODEC_ZSTD = 3,    // raw bytes through zstd (only with MINECRAFT_HAVE_ZSTD)
+    CODEC_LZ4 = 4,     // raw bytes through LZ4 (only with MINECRAFT_HAVE_LZ4)
+};
+
+class ChunkCodec
+{
+public:
+    virtual ~ChunkCodec() {}
+
+    virtual ChunkCodecId id() const = 0;
+    virtual const char *name() const = 0;
+
+    // writes the body, after the id byte. false if it couldnt (a
+    // compressor failed), out is left as it was
+    virtual bool encode(const ChunkBlocks &blocks, std::vector<uint8_t> &out) const = 0;
+
+    // body without the id byte. false if truncated or corrupt
+    virtual bool decode(const uint8_t *data, size_t size, ChunkBlocks &blocks) const = 0;
+};
+
+// every codec compiled in, in id order
+const std::vector<const ChunkCodec *> &chunkCodecs();
+
+// null if the id is unknown (or that codec isnt compiled in)
+const ChunkCodec *findChunkCodec(int id);
+
+// codec new saves use. rle-y unless changed: on generated terrain it is both
+// smaller and faster than palette (see codecbench). false if the id is unknown
+bool setDefaultChunkCodec(int id);
+const ChunkCodec &defaultChunkCodec();
+
+// id byte + body of the given (or the default) codec. if that codec fails
+// the payload is palette encoded instead, it never does
+void encodeChunk(const ChunkBlocks &blocks, std::vector<uint8_t> &out);
+void encodeChunk(const ChunkBlocks &blocks, std::vector<uint8_t> &out, const ChunkCodec &codec);
+
+// decodes any codec straight into blocks. false if the payload is truncated,
+// corrupt or uses an unknown codec
+bool decodeChunk(const uint8_t *data, size_t size, ChunkBlocks &blocks);
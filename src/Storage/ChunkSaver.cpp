@@ -0,0 +1,226 @@
+#include "Storage/ChunkSaver.hpp"
+#include "Profiler/Metrics.hpp"
+#include "Profiler/Profiler.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+ChunkSaver::ChunkSaver(int intervalMs) : intervalMs(intervalMs)
+{
+    thread = std::thread(&ChunkSaver::saverLoop, this);
+}
+
+ChunkSaver::~ChunkSaver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!entries.empty())
+        std::cerr << "ChunkSaver: " << entries.size() << " chunks could not be saved" << std::endl;
+    while (!entries.empty())
+        erase(entries.begin());
+}
+
+void ChunkSaver::erase(std::map<Key, Entry>::iterator it)
+{
+    entries.erase(it);
+    Metrics::decrement(METRIC_DIRTY_CHUNKS);
+}
+
+void ChunkSaver::markDirty(const std::shared_ptr<ChunkData> &data, const std::shared_ptr<RegionStore> &store)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Key key(store->getDirectory(), data->chunkX, data->chunkZ);
+    auto it = entries.find(key);
+    if (it == entries.end())
+    {
+        Metrics::increment(METRIC_DIRTY_CHUNKS);
+        entries.insert(std::make_pair(key, Entry{data, store, false}));
+    }
+    else if (it->second.data != data)
+    {
+        it->second = Entry{data, store, false};
+    }
+    // same chunk: keep the unloaded flag, a worker may mark it after the
+    // chunk was already dropped
+}
+
+void ChunkSaver::saveOnUnload(const std::shared_ptr<ChunkData> &data, const std::shared_ptr<RegionStore> &store)
+{
+    if (!data->isDirty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Key key(store->getDirectory(), data->chunkX, data->chunkZ);
+        auto it = entries.find(key);
+        if (it == entries.end())
+        {
+            Metrics::increment(METRIC_DIRTY_CHUNKS);
+            it = entries.insert(std::make_pair(key, Entry{data, store, false})).first;
+        }
+        it->second.unloaded = true;
+        saveRequested = true;
+    }
+    wake.notify_one();
+}
+
+bool ChunkSaver::reclaim(ChunkData &data, const std::shared_ptr<RegionStore> &store)
+{
+    std::shared_ptr<ChunkData> old;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(Key(store->getDirectory(), data.chunkX, data.chunkZ));
+        if (it == entries.end() || !it->second.unloaded)
+            return false;
+        old = it->second.data;
+        erase(it);
+    }
+
+    // nothing edits an unloaded chunk, the lock only keeps out a saver
+    // pass that is reading it right now
+    {
+        std::lock_guard<std::mutex> lock(old->blocksMutex);
+        std::memcpy(data.blocks, old->blocks, sizeof(ChunkBlocks));
+    }
+
+    // the caller registers data with markDirty once it is loaded
+    data.markEdited();
+    return true;
+}
+
+void ChunkSaver::requestSave()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        saveRequested = true;
+    }
+    wake.notify_one();
+}
+
+void ChunkSaver::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    // a pass already running may have snapshotted before the latest marks
+    unsigned long long target = passesStarted + 1;
+    saveRequested = true;
+    wake.notify_one();
+    passDone.wait(lock, [this, target]() { return passesDone >= target || stopping; });
+}
+
+int ChunkSaver::getDirtyCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)entries.size();
+}
+
+void ChunkSaver::saverLoop()
+{
+    Profiler::setThreadName("chunk saver");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]() { return saveRequested || stopping; });
+        bool last = stopping;
+        saveRequested = false;
+        passesStarted++;
+
+        lock.unlock();
+        savePass();
+        lock.lock();
+
+        passesDone++;
+        passDone.notify_all();
+        if (last)
+            return;
+    }
+}
+
+void ChunkSaver::savePass()
+{
+    struct Snapshot
+    {
+        Key key;
+        Entry entry;
+        uint32_t version;
+        RegionStore::Payload payload;
+    };
+
+    std::vector<Snapshot> snapshots;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &it : entries)
+            snapshots.push_back(Snapshot{it.first, it.second, 0, nullptr});
+    }
+    if (snapshots.empty())
+        return;
+
+    PROFILE_SCOPE("autosave");
+
+    // copy under the chunk lock, encode outside of it, so an edit on the
+    // render thread waits at most for a 32KB copy
+    struct BlockBuffer
+    {
+        ChunkBlocks blocks;
+    };
+    std::unique_ptr<BlockBuffer> buffer(new BlockBuffer());
+    for (Snapshot &snapshot : snapshots)
+    {
+        ChunkData &data = *snapshot.entry.data;
+        {
+            std::lock_guard<std::mutex> lock(data.blocksMutex);
+            snapshot.version = data.getVersion();
+            std::memcpy(buffer->blocks, data.blocks, sizeof(ChunkBlocks));
+        }
+        snapshot.payload = snapshot.entry.store->stageChunk(data.chunkX, data.chunkZ, buffer->blocks);
+    }
+
+    // one journaled batch per world
+    std::vector<bool> written(snapshots.size(), false);
+    for (size_t i = 0; i < snapshots.size(); i++)
+    {
+        if (written[i])
+            continue;
+
+        RegionStore *store = snapshots[i].entry.store.get();
+        std::vector<std::pair<RegionStore::ChunkKey, RegionStore::Payload>> batch;
+        std::vector<size_t> members;
+        for (size_t j = i; j < snapshots.size(); j++)
+        {
+            if (snapshots[j].entry.store.get() != store)
+                continue;
+            ChunkData &data = *snapshots[j].entry.data;
+            batch.push_back(std::make_pair(std::make_pair(data.chunkX, data.chunkZ), snapshots[j].payload));
+            members.push_back(j);
+        }
+
+        bool ok = store->writeBatch(batch);
+        for (size_t j : members)
+        {
+            written[j] = true;
+            if (ok)
+                snapshots[j].entry.data->markSaved(snapshots[j].version);
+        }
+        if (ok)
+            Metrics::increment(METRIC_AUTOSAVE_BATCHES);
+        else
+            std::cerr << "ChunkSaver: batch of " << batch.size() << " chunks failed, retrying later" << std::endl;
+    }
+
+    // forget what is clean now, unless it was replaced meanwhile
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Snapshot &snapshot : snapshots)
+    {
+        auto it = entries.find(snapshot.key);
+        if (it != entries.end() && it->second.data == snapshot.entry.data && !it->second.data->isDirty())
+            erase(it);
+    }
+}
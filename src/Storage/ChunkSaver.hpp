@@ -0,0 +1,79 @@
+#pragma once
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include "World/ChunkData.hpp"
+#include "Storage/RegionStore.hpp"
+
+// background autosave of edited chunks. the render thread only registers
+// chunks here (a short lock, no io), the saver thread snapshots them under
+// their blocksMutex, encodes them and writes them in journaled batches
+// every interval, or right away when a dirty chunk gets unloaded.
+//
+// an unloaded dirty chunk stays here until it is written. if it comes back
+// before that, reclaim hands its blocks to the new chunk, so a reload never
+// sees the older copy on disk
+class ChunkSaver
+{
+public:
+    explicit ChunkSaver(int intervalMs = 5000);
+
+    // saves everything left, then stops the thread
+    ~ChunkSaver();
+
+    ChunkSaver(const ChunkSaver &) = delete;
+    ChunkSaver &operator=(const ChunkSaver &) = delete;
+
+    // after an edit (markEdited) of a loaded chunk
+    void markDirty(const std::shared_ptr<ChunkData> &data, const std::shared_ptr<RegionStore> &store);
+
+    // before the chunk is dropped. no-op if it isnt dirty
+    void saveOnUnload(const std::shared_ptr<ChunkData> &data, const std::shared_ptr<RegionStore> &store);
+
+    // copies the blocks of an unloaded chunk that wasnt written yet into
+    // data and takes over its dirtiness. false if there is none. any thread
+    bool reclaim(ChunkData &data, const std::shared_ptr<RegionStore> &store);
+
+    // starts a save now instead of at the next interval
+    void requestSave();
+
+    // blocks until every chunk marked so far has been written (or failed)
+    void flush();
+
+    int getDirtyCount();
+
+private:
+    // by world directory, not store: a reload reclaims its own dirty
+    // chunks whatever store it got
+    typedef std::tuple<std::string, int, int> Key;
+
+    struct Entry
+    {
+        std::shared_ptr<ChunkData> data;
+        std::shared_ptr<RegionStore> store;
+        bool unloaded;
+    };
+
+    const int intervalMs;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable passDone;
+    std::map<Key, Entry> entries;
+    bool saveRequested = false;
+    bool stopping = false;
+    unsigned long long passesStarted = 0;
+    unsigned long long passesDone = 0;
+
+    // last member, started once everything above is initialized
+    std::thread thread;
+
+    void saverLoop();
+    void savePass();
+    void erase(std::map<Key, Entry>::iterator it);
+};
@@ -0,0 +1,59 @@
+#include "Storage/MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+bool MappedFile::map(FILE *file, size_t size)
+{
+    unmap();
+    if (!file || size == 0)
+        return false;
+
+    fflush(file);
+
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        return false;
+
+    bytes = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    if (!bytes)
+    {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+#else
+    void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileno(file), 0);
+    if (address == MAP_FAILED)
+        return false;
+
+    bytes = (const uint8_t *)address;
+#endif
+
+    length = size;
+    return true;
+}
+
+void MappedFile::unmap()
+{
+    if (!bytes)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(bytes);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap((void *)bytes, length);
+#endif
+
+    bytes = nullptr;
+    length = 0;
+}
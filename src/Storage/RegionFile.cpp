@@ -0,0 +1,276 @@
+#include "Storage/RegionFile.hpp"
+#include "Storage/RegionStore.hpp"
+
+#include <cstring>
+#include <ctime>
+
+static const int HEADER_SECTORS = 2;
+
+// sectors are addressed with 24 bits, a chunk can use up to 255 of them
+static const uint32_t MAX_SECTOR = 0xFFFFFF;
+static const int MAX_CHUNK_SECTORS = 255;
+
+// the file grows by this many sectors (1 MB) at a time, so appends rarely
+// have to remap it
+static const int GROW_SECTORS = 256;
+
+static void writeU32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t readU32(const uint8_t *src)
+{
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+RegionFile::RegionFile(const std::string &path, bool create)
+{
+    memset(locations, 0, sizeof(locations));
+    memset(timestamps, 0, sizeof(timestamps));
+
+    file = fopen(path.c_str(), "r+b");
+    if (!file && !create)
+        return;
+    if (!file)
+    {
+        // new region, write an empty header
+        file = fopen(path.c_str(), "w+b");
+        if (!file)
+            return;
+
+        uint8_t empty[HEADER_SECTORS * SECTOR_BYTES] = {};
+        fwrite(empty, 1, sizeof(empty), file);
+        fflush(file);
+    }
+
+    uint8_t header[HEADER_SECTORS * SECTOR_BYTES];
+    fseek(file, 0, SEEK_SET);
+    if (fread(header, 1, sizeof(header), file) != sizeof(header))
+    {
+        fclose(file);
+        file = nullptr;
+        return;
+    }
+
+    fseek(file, 0, SEEK_END);
+    fileSize = (size_t)ftell(file);
+    usedSectors.assign((fileSize + SECTOR_BYTES - 1) / SECTOR_BYTES, false);
+    for (int i = 0; i < HEADER_SECTORS; i++)
+        usedSectors[i] = true;
+
+    for (int i = 0; i < REGION_CHUNKS; i++)
+    {
+        locations[i] = readU32(header + i * 4);
+        timestamps[i] = readU32(header + SECTOR_BYTES + i * 4);
+
+        uint32_t sector = locations[i] >> 8;
+        uint32_t count = locations[i] & 0xFF;
+
+        // entries pointing outside the file are treated as missing
+        if (locations[i] != 0 && (sector < HEADER_SECTORS || sector + count > usedSectors.size()))
+        {
+            locations[i] = 0;
+            continue;
+        }
+        for (uint32_t s = sector; s < sector + count; s++)
+            usedSectors[s] = true;
+    }
+
+    remap();
+}
+
+void RegionFile::remap()
+{
+    // falls back to fread if this fails
+    if (!mapped.map(file, fileSize))
+        mapped.unmap();
+}
+
+RegionFile::~RegionFile()
+{
+    mapped.unmap();
+    if (file)
+        fclose(file);
+}
+
+bool RegionFile::hasChunk(int localX, int localZ)
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    return locations[localX + localZ * REGION_SIZE] != 0;
+}
+
+bool RegionFile::readChunk(int localX, int localZ, const std::function<bool(const uint8_t *, size_t)> &visit)
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    if (!file)
+        return false;
+
+    int index = localX + localZ * REGION_SIZE;
+    uint32_t location = locations[index];
+    if (location == 0)
+        return false;
+
+    size_t offset = (size_t)(location >> 8) * SECTOR_BYTES;
+    size_t capacity = (size_t)(location & 0xFF) * SECTOR_BYTES;
+
+    if (mapped.data() && offset + capacity <= mapped.size())
+    {
+        // straight from the mapping, the shared lock keeps writers (and
+        // remaps) out until visit is done
+        const uint8_t *sector = mapped.data() + offset;
+        uint32_t length = readU32(sector);
+        if (length == 0 || length + 4 > capacity)
+            return false;
+
+        return visit(sector + 4, length);
+    }
+
+    // no mapping, read it. fseek moves the shared FILE position so this
+    // path needs the file to itself. a write may have moved the chunk
+    // while no lock was held, so its location is read again
+    lock.unlock();
+    std::unique_lock<std::shared_timed_mutex> exclusive(mutex);
+    location = locations[index];
+    if (location == 0)
+        return false;
+    offset = (size_t)(location >> 8) * SECTOR_BYTES;
+    capacity = (size_t)(location & 0xFF) * SECTOR_BYTES;
+
+    std::vector<uint8_t> buffer(capacity);
+    fseek(file, (long)offset, SEEK_SET);
+    if (fread(buffer.data(), 1, capacity, file) != capacity)
+        return false;
+
+    uint32_t length = readU32(buffer.data());
+    if (length == 0 || length + 4 > capacity)
+        return false;
+
+    return visit(buffer.data() + 4, length);
+}
+
+int RegionFile::allocateSectors(int count)
+{
+    // first free run big enough
+    int runStart = 0;
+    int runLength = 0;
+    for (int s = HEADER_SECTORS; s < (int)usedSectors.size(); s++)
+    {
+        if (usedSectors[s])
+        {
+            runLength = 0;
+            continue;
+        }
+        if (runLength == 0)
+            runStart = s;
+        if (++runLength == count)
+            return runStart;
+    }
+
+    // or grow the file (reusing a free run at the end)
+    int start = runLength > 0 ? runStart : (int)usedSectors.size();
+    if ((uint32_t)(start + count) > MAX_SECTOR)
+        return -1;
+
+    usedSectors.resize(start + count, false);
+    return start;
+}
+
+// extends the file past end, to a whole GROW_SECTORS step, and remaps it
+bool RegionFile::growTo(size_t end)
+{
+    size_t step = (size_t)GROW_SECTORS * SECTOR_BYTES;
+    size_t size = (end + step - 1) / step * step;
+    uint8_t zero = 0;
+    fseek(file, (long)size - 1, SEEK_SET);
+    if (fwrite(&zero, 1, 1, file) != 1)
+        return false;
+    fflush(file);
+
+    fileSize = size;
+    usedSectors.resize(size / SECTOR_BYTES, false);
+    remap();
+    return true;
+}
+
+bool RegionFile::writeHeaderEntry(int index)
+{
+    uint8_t bytes[4];
+
+    writeU32(bytes, locations[index]);
+    fseek(file, (long)index * 4, SEEK_SET);
+    if (fwrite(bytes, 1, 4, file) != 4)
+        return false;
+
+    writeU32(bytes, timestamps[index]);
+    fseek(file, (long)SECTOR_BYTES + index * 4, SEEK_SET);
+    return fwrite(bytes, 1, 4, file) == 4;
+}
+
+bool RegionFile::writeChunk(int localX, int localZ, const uint8_t *payload, size_t size)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    if (!file)
+        return false;
+
+    int index = localX + localZ * REGION_SIZE;
+    int needed = (int)((size + 4 + SECTOR_BYTES - 1) / SECTOR_BYTES);
+    if (needed > MAX_CHUNK_SECTORS)
+        return false;
+
+    uint32_t oldLocation = locations[index];
+
+    // never overwrite the current version, the old sectors stay used until
+    // the header pointing at the new ones is synced
+    int sector = allocateSectors(needed);
+    if (sector < 0)
+        return false;
+    size_t end = (size_t)(sector + needed) * SECTOR_BYTES;
+    if (end > fileSize && !growTo(end))
+        return false;
+
+    // data first, zero padded to whole sectors
+    std::vector<uint8_t> buffer(needed * SECTOR_BYTES, 0);
+    writeU32(buffer.data(), (uint32_t)size);
+    memcpy(buffer.data() + 4, payload, size);
+
+    fseek(file, (long)sector * SECTOR_BYTES, SEEK_SET);
+    if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+        return false;
+    fflush(file);
+
+    for (int s = sector; s < sector + needed; s++)
+        usedSectors[s] = true;
+
+    // then point the header at it
+    locations[index] = ((uint32_t)sector << 8) | (uint32_t)needed;
+    timestamps[index] = (uint32_t)time(nullptr);
+    if (!writeHeaderEntry(index))
+        return false;
+    fflush(file);
+
+    // old sectors are free once the header on disk no longer points there
+    if (oldLocation != 0)
+        pendingFree.push_back(oldLocation);
+
+    return true;
+}
+
+bool RegionFile::sync()
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    if (!file || !syncFile(file))
+        return false;
+
+    for (uint32_t location : pendingFree)
+    {
+        uint32_t sector = location >> 8;
+        for (uint32_t s = sector; s < sector + (location & 0xFF); s++)
+            usedSectors[s] = false;
+    }
+    pendingFree.clear();
+    return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "Storage/MappedFile.hpp"
+
+// REGION_SIZE x REGION_SIZE chunks per file
+const int REGION_SIZE = 32;
+const int REGION_CHUNKS = REGION_SIZE * REGION_SIZE;
+const int SECTOR_BYTES = 4096;
+
+// layout (all integers little endian):
+//   sector 0: REGION_CHUNKS x u32 location = first sector << 8 | sector count (0 = chunk not stored)
+//   sector 1: REGION_CHUNKS x u32 unix time of the last write
+//   then the chunks, each starting on a sector: u32 payload length, payload
+// a write goes to the first free run of sectors (or the end of the file),
+// never over the current version, and the header entry is written after the
+// data. a crash mid write leaves the previous version of the chunk readable.
+// the sectors of the previous version are only reused after the next sync,
+// until then the header on disk may still point at them.
+//
+// reads go through a read-only mapping of the whole file and hand the
+// payload to the caller straight from the mapped pages, no read syscall or
+// copy. any number of reads run at once, a write waits for them. the file
+// grows GROW_SECTORS at a time and is only remapped then.
+//
+// thread safe
+class RegionFile
+{
+public:
+    // create = false leaves the file closed if it doesnt exist yet
+    RegionFile(const std::string &path, bool create);
+    ~RegionFile();
+
+    RegionFile(const RegionFile &) = delete;
+    RegionFile &operator=(const RegionFile &) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    // localX, localZ in 0..REGION_SIZE-1
+    bool hasChunk(int localX, int localZ);
+
+    // calls visit(payload, size) while the payload is guaranteed to stay
+    // valid, returns what visit returned (false if the chunk isnt stored)
+    bool readChunk(int localX, int localZ, const std::function<bool(const uint8_t *, size_t)> &visit);
+    bool writeChunk(int localX, int localZ, const uint8_t *payload, size_t size);
+
+    // data and header on disk (fsync), then the sectors of replaced chunk
+    // versions are free
+    bool sync();
+
+private:
+    FILE *file = nullptr;
+    std::shared_timed_mutex mutex; // shared for reads, exclusive for writes
+
+    MappedFile mapped;
+    size_t fileSize = 0;
+
+    uint32_t locations[REGION_CHUNKS];
+    uint32_t timestamps[REGION_CHUNKS];
+    std::vector<bool> usedSectors; // one per sector of the file
+    std::vector<uint32_t> pendingFree; // locations replaced since the last sync
+
+    bool writeHeaderEntry(int index);
+    int allocateSectors(int count);
+    bool growTo(size_t end);
+    void remap();
+};
@@ -0,0 +1,435 @@
+#include "Storage/RegionStore.hpp"
+#include "Storage/ChunkCodec.hpp"
+#include "Profiler/Metrics.hpp"
+#include "Profiler/Profiler.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#define MAKE_DIR(path) _mkdir(path)
+#define SYNC_FD(fd) _commit(fd)
+#define FILE_FD(file) _fileno(file)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAKE_DIR(path) mkdir(path, 0755)
+#define SYNC_FD(fd) fsync(fd)
+#define FILE_FD(file) fileno(file)
+#endif
+
+// journal layout: a header, then per chunk (x, z, size, payload, checksum),
+// then a trailer repeating the count. a journal without a matching trailer
+// or with a bad checksum was cut off before its regions were touched, so
+// it is dropped
+static const uint32_t JOURNAL_MAGIC = 0x4c4a434d;   // "MCJL"
+static const uint32_t JOURNAL_TRAILER = 0x454e4f44; // "DONE"
+
+// region files open at once. the render and LOD distances touch a few
+// dozen regions at most
+static const size_t MAX_OPEN_REGIONS = 32;
+
+// io thread writes between syncs while its queue stays full (generating a
+// new area)
+static const int SYNC_EVERY_WRITES = 64;
+
+bool makeDirectories(const std::string &path)
+{
+    for (size_t i = 1; i <= path.size(); i++)
+    {
+        if (i == path.size() || path[i] == '/' || path[i] == '\\')
+        {
+            std::string part = path.substr(0, i);
+            MAKE_DIR(part.c_str()); // fails harmlessly if it exists
+        }
+    }
+
+    FILE *probe = fopen((path + "/.probe").c_str(), "wb");
+    if (!probe)
+        return false;
+    fclose(probe);
+    remove((path + "/.probe").c_str());
+    return true;
+}
+
+bool syncFile(FILE *file)
+{
+    if (fflush(file) != 0)
+        return false;
+    return SYNC_FD(FILE_FD(file)) == 0;
+}
+
+// fnv-1a, enough to catch a torn journal write
+static uint32_t checksum(const uint8_t *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool writeU32(FILE *file, uint32_t value)
+{
+    return fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+static bool readU32(FILE *file, uint32_t &value)
+{
+    return fread(&value, sizeof(value), 1, file) == 1;
+}
+
+// region coordinate of a chunk coordinate, rounding down for negatives
+static int regionCoord(int chunkCoord)
+{
+    return chunkCoord >= 0 ? chunkCoord / REGION_SIZE : (chunkCoord + 1) / REGION_SIZE - 1;
+}
+
+static int regionLocal(int chunkCoord)
+{
+    return chunkCoord - regionCoord(chunkCoord) * REGION_SIZE;
+}
+
+// the stores in use, by directory. never freed, a store can be released
+// by a global during exit
+struct StoreRegistry
+{
+    std::mutex mutex;
+    std::condition_variable closed;
+    std::map<std::string, std::weak_ptr<RegionStore>> stores;
+};
+
+static StoreRegistry &storeRegistry()
+{
+    static StoreRegistry *registry = new StoreRegistry();
+    return *registry;
+}
+
+std::shared_ptr<RegionStore> RegionStore::open(const std::string &directory)
+{
+    StoreRegistry &registry = storeRegistry();
+    std::unique_lock<std::mutex> lock(registry.mutex);
+    while (true)
+    {
+        auto it = registry.stores.find(directory);
+        if (it == registry.stores.end())
+            break;
+        if (std::shared_ptr<RegionStore> store = it->second.lock())
+            return store;
+
+        // the last user let go and it is still writing its queue out
+        registry.closed.wait(lock);
+    }
+
+    // the entry goes only once the store is gone, so a store for the same
+    // directory never starts while the old one still writes
+    std::shared_ptr<RegionStore> store(new RegionStore(directory), [directory](RegionStore *closing) {
+        delete closing;
+        StoreRegistry &registry = storeRegistry();
+        {
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.stores.erase(directory);
+        }
+        registry.closed.notify_all();
+    });
+    registry.stores[directory] = store;
+    return store;
+}
+
+RegionStore::RegionStore(const std::string &directory) : directory(directory), io(1, "region io")
+{
+    if (!makeDirectories(directory))
+        std::cerr << "RegionStore: cannot write to " << directory << std::endl;
+
+    replayJournal();
+}
+
+RegionStore::~RegionStore()
+{
+    flush();
+}
+
+void RegionStore::flush()
+{
+    io.wait();
+    std::lock_guard<std::mutex> writeLock(writeMutex);
+    syncWritten();
+}
+
+std::shared_ptr<RegionFile> RegionStore::getRegion(int chunkX, int chunkZ, bool create)
+{
+    std::pair<int, int> key = std::make_pair(regionCoord(chunkX), regionCoord(chunkZ));
+
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    auto it = regions.find(key);
+    if (it != regions.end())
+    {
+        it->second.lastUse = ++regionUses;
+        return it->second.file;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "/r.%d.%d.region", key.first, key.second);
+    std::shared_ptr<RegionFile> region = std::make_shared<RegionFile>(directory + name, create);
+
+    // missing regions arent cached, the first save creates them
+    if (!region->isOpen())
+        return nullptr;
+
+    if (regions.size() >= MAX_OPEN_REGIONS)
+        closeUnusedRegion();
+    regions[key] = OpenRegion{region, ++regionUses};
+    return region;
+}
+
+// under regionsMutex. only a file no one else holds is closed: no read or
+// write is in it and none can start, so the next getRegion opening it
+// again never runs next to this one. if all are held the set grows for now
+void RegionStore::closeUnusedRegion()
+{
+    auto oldest = regions.end();
+    for (auto it = regions.begin(); it != regions.end(); it++)
+    {
+        if (it->second.file.use_count() == 1 && (oldest == regions.end() || it->second.lastUse < oldest->second.lastUse))
+            oldest = it;
+    }
+    if (oldest == regions.end())
+        return;
+
+    oldest->second.file->sync();
+    regions.erase(oldest);
+}
+
+bool RegionStore::loadChunk(int chunkX, int chunkZ, ChunkBlocks &blocks)
+{
+    PROFILE_SCOPE("loadChunk");
+
+    Payload payload;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        auto it = pending.find(std::make_pair(chunkX, chunkZ));
+        if (it != pending.end())
+            payload = it->second;
+    }
+
+    bool loaded = false;
+    if (payload)
+    {
+        loaded = decodeChunk(payload->data(), payload->size(), blocks);
+    }
+    else
+    {
+        // decoded straight out of the mapped region into the chunk
+        std::shared_ptr<RegionFile> region = getRegion(chunkX, chunkZ, false);
+        loaded = region && region->readChunk(regionLocal(chunkX), regionLocal(chunkZ), [&blocks](const uint8_t *data, size_t size)
+                                             { return decodeChunk(data, size, blocks); });
+    }
+
+    if (loaded)
+        Metrics::increment(METRIC_CHUNKS_LOADED_FROM_DISK);
+    return loaded;
+}
+
+void RegionStore::saveChunkAsync(int chunkX, int chunkZ, const ChunkBlocks &blocks)
+{
+    std::shared_ptr<std::vector<uint8_t>> payload = std::make_shared<std::vector<uint8_t>>();
+    encodeChunk(blocks, *payload);
+
+    ChunkKey key = std::make_pair(chunkX, chunkZ);
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending[key] = payload;
+    }
+
+    io.enqueue([this, key, payload]() { writePending(key, payload); });
+}
+
+RegionStore::Payload RegionStore::stageChunk(int chunkX, int chunkZ, const ChunkBlocks &blocks)
+{
+    std::shared_ptr<std::vector<uint8_t>> payload = std::make_shared<std::vector<uint8_t>>();
+    encodeChunk(blocks, *payload);
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending[std::make_pair(chunkX, chunkZ)] = payload;
+    return payload;
+}
+
+bool RegionStore::isLatest(ChunkKey key, const Payload &payload)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    auto it = pending.find(key);
+    return it != pending.end() && it->second == payload;
+}
+
+void RegionStore::forgetPending(ChunkKey key, const Payload &payload)
+{
+    // only forget it if no newer save came in meanwhile
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    auto it = pending.find(key);
+    if (it != pending.end() && it->second == payload)
+        pending.erase(it);
+}
+
+void RegionStore::writePending(ChunkKey key, Payload payload)
+{
+    PROFILE_SCOPE("writeChunk");
+    std::lock_guard<std::mutex> writeLock(writeMutex);
+
+    // a newer version was staged since, it gets written on its own
+    if (isLatest(key, payload))
+    {
+        std::shared_ptr<RegionFile> region = getRegion(key.first, key.second, true);
+        if (!region || !region->writeChunk(regionLocal(key.first), regionLocal(key.second), payload->data(), payload->size()))
+        {
+            std::cerr << "RegionStore: failed to write chunk " << key.first << ", " << key.second << std::endl;
+        }
+        else
+        {
+            Metrics::increment(METRIC_CHUNKS_SAVED);
+            if (std::find(unsynced.begin(), unsynced.end(), region) == unsynced.end())
+                unsynced.push_back(region);
+            unsyncedWrites++;
+        }
+        forgetPending(key, payload);
+    }
+
+    // this job isnt queued anymore, so 0 means the queue ran dry
+    if (unsyncedWrites >= SYNC_EVERY_WRITES || io.getQueuedCount() == 0)
+        syncWritten();
+}
+
+// under writeMutex
+void RegionStore::syncWritten()
+{
+    for (const std::shared_ptr<RegionFile> &region : unsynced)
+    {
+        if (!region->sync())
+            std::cerr << "RegionStore: failed to sync a region of " << directory << std::endl;
+    }
+    unsynced.clear();
+    unsyncedWrites = 0;
+}
+
+bool RegionStore::writeBatch(const std::vector<std::pair<ChunkKey, Payload>> &batch)
+{
+    PROFILE_SCOPE("writeBatch");
+    if (batch.empty())
+        return true;
+
+    std::lock_guard<std::mutex> writeLock(writeMutex);
+
+    // 1. the whole batch goes to the journal and is synced
+    FILE *journal = fopen(journalPath().c_str(), "wb");
+    if (!journal)
+    {
+        std::cerr << "RegionStore: cannot open " << journalPath() << std::endl;
+        return false;
+    }
+
+    bool ok = writeU32(journal, JOURNAL_MAGIC) && writeU32(journal, (uint32_t)batch.size());
+    for (size_t i = 0; ok && i < batch.size(); i++)
+    {
+        const std::vector<uint8_t> &payload = *batch[i].second;
+        ok = writeU32(journal, (uint32_t)batch[i].first.first) && writeU32(journal, (uint32_t)batch[i].first.second) &&
+             writeU32(journal, (uint32_t)payload.size()) &&
+             fwrite(payload.data(), 1, payload.size(), journal) == payload.size() &&
+             writeU32(journal, checksum(payload.data(), payload.size()));
+    }
+    ok = ok && writeU32(journal, JOURNAL_TRAILER) && writeU32(journal, (uint32_t)batch.size()) && syncFile(journal);
+    fclose(journal);
+
+    if (!ok)
+    {
+        std::cerr << "RegionStore: failed to write the journal" << std::endl;
+        remove(journalPath().c_str());
+        return false;
+    }
+
+    // 2. the regions, each synced once
+    std::vector<std::shared_ptr<RegionFile>> touched;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        ChunkKey key = batch[i].first;
+        std::shared_ptr<RegionFile> region = getRegion(key.first, key.second, true);
+        if (!region || !region->writeChunk(regionLocal(key.first), regionLocal(key.second), batch[i].second->data(), batch[i].second->size()))
+        {
+            std::cerr << "RegionStore: failed to write chunk " << key.first << ", " << key.second << std::endl;
+            ok = false;
+            continue;
+        }
+        Metrics::increment(METRIC_CHUNKS_SAVED);
+
+        if (std::find(touched.begin(), touched.end(), region) == touched.end())
+            touched.push_back(region);
+    }
+    for (const std::shared_ptr<RegionFile> &region : touched)
+        ok = region->sync() && ok;
+
+    // 3. done, the journal isnt needed anymore. on failure it stays and is
+    // replayed next time
+    if (!ok)
+        return false;
+
+    remove(journalPath().c_str());
+    for (size_t i = 0; i < batch.size(); i++)
+        forgetPending(batch[i].first, batch[i].second);
+    return true;
+}
+
+void RegionStore::replayJournal()
+{
+    FILE *journal = fopen(journalPath().c_str(), "rb");
+    if (!journal)
+        return;
+
+    std::vector<std::pair<ChunkKey, std::vector<uint8_t>>> entries;
+    uint32_t magic = 0, count = 0;
+    bool ok = readU32(journal, magic) && magic == JOURNAL_MAGIC && readU32(journal, count);
+    for (uint32_t i = 0; ok && i < count; i++)
+    {
+        uint32_t x = 0, z = 0, size = 0, sum = 0;
+        ok = readU32(journal, x) && readU32(journal, z) && readU32(journal, size) && size <= SECTOR_BYTES * 255;
+        if (!ok)
+            break;
+
+        std::vector<uint8_t> payload(size);
+        ok = fread(payload.data(), 1, size, journal) == size && readU32(journal, sum) && sum == checksum(payload.data(), size);
+        entries.push_back(std::make_pair(std::make_pair((int)x, (int)z), std::move(payload)));
+    }
+    uint32_t trailer = 0, trailerCount = 0;
+    ok = ok && readU32(journal, trailer) && trailer == JOURNAL_TRAILER && readU32(journal, trailerCount) && trailerCount == count;
+    fclose(journal);
+
+    if (ok)
+    {
+        std::vector<std::shared_ptr<RegionFile>> touched;
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            ChunkKey key = entries[i].first;
+            std::shared_ptr<RegionFile> region = getRegion(key.first, key.second, true);
+            if (!region || !region->writeChunk(regionLocal(key.first), regionLocal(key.second), entries[i].second.data(), entries[i].second.size()))
+            {
+                // leave the journal for the next try
+                std::cerr << "RegionStore: failed to replay chunk " << key.first << ", " << key.second << std::endl;
+                return;
+            }
+            if (std::find(touched.begin(), touched.end(), region) == touched.end())
+                touched.push_back(region);
+        }
+        for (const std::shared_ptr<RegionFile> &region : touched)
+            region->sync();
+        std::cout << "RegionStore: replayed " << entries.size() << " chunks from the journal" << std::endl;
+    }
+    else
+    {
+        std::cout << "RegionStore: dropping an incomplete journal" << std::endl;
+    }
+
+    remove(journalPath().c_str());
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "World/Block.hpp"
+#include "Storage/RegionFile.hpp"
+#include "Core/ThreadPool.hpp"
+
+// all the region files of one world directory. loads are synchronous and
+// meant to be called from chunk workers, saves are encoded on the caller
+// and written by the store's own io thread. a chunk waiting to be written
+// is served from memory, so a load never sees an older version than the
+// last save. region files written by the io thread are synced once its
+// queue runs dry (or every few dozen writes), which also frees the sectors
+// of the versions they replaced. at most MAX_OPEN_REGIONS files stay open,
+// past that the least recently used one nobody holds is synced and closed.
+// thread safe
+//
+// edited chunks go through writeBatch instead, which is journaled: the
+// batch is appended to journal.bin and synced before any region file is
+// touched, and the journal is cleared once the regions are synced. a batch
+// interrupted by a crash is replayed from the journal on the next open.
+//
+// there is only ever one store per directory (open), two would hand out
+// the same sectors of a region file and share journal.bin
+class RegionStore
+{
+public:
+    typedef std::pair<int, int> ChunkKey;
+    typedef std::shared_ptr<const std::vector<uint8_t>> Payload;
+
+    // the store of directory, the one still in use if there is one. a new
+    // one creates the directory if needed and replays an unfinished
+    // journal. one that is being closed is waited for first
+    static std::shared_ptr<RegionStore> open(const std::string &directory);
+
+    RegionStore(const RegionStore &) = delete;
+    RegionStore &operator=(const RegionStore &) = delete;
+
+    // false if the chunk was never saved (or its data is unreadable)
+    bool loadChunk(int chunkX, int chunkZ, ChunkBlocks &blocks);
+
+    void saveChunkAsync(int chunkX, int chunkZ, const ChunkBlocks &blocks);
+
+    // encodes the chunk and serves it to loads from now on, without writing
+    // it. pass the result to writeBatch
+    Payload stageChunk(int chunkX, int chunkZ, const ChunkBlocks &blocks);
+
+    // journaled write of staged chunks, synchronous. false if anything failed
+    // (the staged copies stay in memory then)
+    bool writeBatch(const std::vector<std::pair<ChunkKey, Payload>> &batch);
+
+    // blocks until queued saves are on disk (synced)
+    void flush();
+
+    const std::string &getDirectory() const { return directory; }
+
+private:
+    std::string directory;
+
+    explicit RegionStore(const std::string &directory);
+
+    // writes everything still queued
+    ~RegionStore();
+
+    // one writer at a time, so a queued write of an older version cant land
+    // after a newer one
+    std::mutex writeMutex;
+
+    struct OpenRegion
+    {
+        std::shared_ptr<RegionFile> file;
+        uint64_t lastUse;
+    };
+    std::mutex regionsMutex;
+    std::map<std::pair<int, int>, OpenRegion> regions;
+    uint64_t regionUses = 0;
+
+    // written by the io thread since their last sync (under writeMutex),
+    // held so they arent closed before
+    std::vector<std::shared_ptr<RegionFile>> unsynced;
+    int unsyncedWrites = 0;
+
+    std::mutex pendingMutex;
+    std::map<ChunkKey, Payload> pending;
+
+    // last member, so it stops before the regions it writes to are closed
+    ThreadPool io;
+
+    // null if the region cant be opened (or doesnt exist and create is false)
+    std::shared_ptr<RegionFile> getRegion(int chunkX, int chunkZ, bool create);
+    void closeUnusedRegion();
+    void writePending(ChunkKey key, Payload payload);
+    void syncWritten();
+
+    // true if payload is still the newest staged version of key
+    bool isLatest(ChunkKey key, const Payload &payload);
+    void forgetPending(ChunkKey key, const Payload &payload);
+
+    std::string journalPath() const { return directory + "/journal.bin"; }
+    void replayJournal();
+};
+
+// mkdir -p
+bool makeDirectories(const std::string &path);
+
+// flushes and asks the OS to put the file on disk
+bool syncFile(FILE *file);
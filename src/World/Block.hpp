@@ -0,0 +1,82 @@
+#pragma once
+
+// blocktypes
+enum BlockType
+{
+    AIR,     // 0
+    GRASS,   // 1
+    DIRT,    // 2
+    STONE,   // 3
+    BEDROCK, // 4
+    LOG,     // 5
+    LEAVES,  // 6
+    WATER,   // 7
+};
+
+// a block value keeps its type in the low 4 bits and a level above them
+// (only water has one), so it still fits the byte per block the codecs store
+const int BLOCK_TYPE_BITS = 4;
+
+inline int blockType(int block)
+{
+    return block & ((1 << BLOCK_TYPE_BITS) - 1);
+}
+
+inline int blockLevel(int block)
+{
+    return block >> BLOCK_TYPE_BITS;
+}
+
+inline int makeBlock(int type, int level)
+{
+    return type | level << BLOCK_TYPE_BITS;
+}
+
+// water levels: a source, flowing water getting weaker away from it, and
+// water falling down a column (spreads like a source where it lands)
+const int WATER_SOURCE = 0;
+const int WATER_MAX_FLOW = 7;
+const int WATER_FALLING = 8;
+
+// leaves the player placed dont decay
+const int LEAVES_PERSISTENT = 1;
+
+// what the player collides with and picks, everything but air and water
+inline bool isSolidBlock(int block)
+{
+    int type = blockType(block);
+    return type != AIR && type != WATER;
+}
+
+// Chunk size
+const int CHUNK_WIDTH = 16;
+const int CHUNK_HEIGHT = 32; // 16 until we add caves via 3D noise
+
+// chunks are meshed and drawn in vertical sections, so an edit only
+// remeshes the sections it touches
+const int SECTION_HEIGHT = 16;
+const int SECTION_COUNT = CHUNK_HEIGHT / SECTION_HEIGHT;
+
+// all the blocks of one chunk, indexed [x][y][z] in chunk local coordinates
+typedef int ChunkBlocks[CHUNK_WIDTH][CHUNK_HEIGHT][CHUNK_WIDTH];
+
+// only the surface of a chunk, for distant chunks that never get their
+// blocks: y of the highest block of each column (-1 if there is none) and
+// its type, indexed [x][z]
+struct ChunkHeightmap
+{
+    int height[CHUNK_WIDTH][CHUNK_WIDTH];
+    int top[CHUNK_WIDTH][CHUNK_WIDTH];
+};
+
+// chunk coordinate of a world block coordinate, rounding down for negatives
+inline int worldToChunk(int world)
+{
+    return world >= 0 ? world / CHUNK_WIDTH : (world + 1) / CHUNK_WIDTH - 1;
+}
+
+// block coordinate inside its chunk, 0..CHUNK_WIDTH-1
+inline int worldToLocal(int world)
+{
+    return world - worldToChunk(world) * CHUNK_WIDTH;
+}
@@ -0,0 +1,316 @@
+#include "World/BlockTicks.hpp"
+#include "World/FluidSimulation.hpp"
+#include "World/Lighting.hpp"
+#include "Profiler/Metrics.hpp"
+#include "Profiler/Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <thread>
+
+// leaves further than this from a log, counted in steps through leaves,
+// decay
+static const int LEAF_DECAY_DISTANCE = 6;
+
+static uint64_t cellKey(int x, int y, int z)
+{
+    return ((uint64_t)(uint32_t)x & 0xFFFFFFF) << 36 | ((uint64_t)(uint32_t)z & 0xFFFFFFF) << 8 | (uint64_t)(y & 0xFF);
+}
+
+bool isRandomTicked(int block)
+{
+    int type = blockType(block);
+    return type == GRASS || (type == LEAVES && blockLevel(block) != LEAVES_PERSISTENT);
+}
+
+void countRandomTicked(const ChunkBlocks &blocks, int counts[SECTION_COUNT])
+{
+    for (int section = 0; section < SECTION_COUNT; section++)
+        counts[section] = 0;
+    for (int x = 0; x < CHUNK_WIDTH; x++)
+        for (int y = 0; y < CHUNK_HEIGHT; y++)
+            for (int z = 0; z < CHUNK_WIDTH; z++)
+                counts[y / SECTION_HEIGHT] += isRandomTicked(blocks[x][y][z]);
+}
+
+// grass under a block that stops light turns to dirt. otherwise it tries
+// one block around it (one up to three down), dirt with light getting to
+// it turns to grass
+static void grassTick(BlockTicker &ticker, int x, int y, int z, std::mt19937 &random)
+{
+    if (y + 1 < CHUNK_HEIGHT)
+    {
+        int above = ticker.getBlock(x, y + 1, z);
+        if (above >= 0 && blockLightOpacity(above) >= MAX_LIGHT)
+        {
+            ticker.setBlock(x, y, z, DIRT);
+            return;
+        }
+    }
+
+    int targetX = x + (int)(random() % 3) - 1;
+    int targetY = y + (int)(random() % 5) - 3;
+    int targetZ = z + (int)(random() % 3) - 1;
+    if (targetY < 0 || targetY >= CHUNK_HEIGHT || ticker.getBlock(targetX, targetY, targetZ) != DIRT)
+        return;
+    if (targetY + 1 < CHUNK_HEIGHT)
+    {
+        int above = ticker.getBlock(targetX, targetY + 1, targetZ);
+        if (above < 0 || blockLightOpacity(above) >= MAX_LIGHT)
+            return;
+    }
+    ticker.setBlock(targetX, targetY, targetZ, GRASS);
+}
+
+// leaves with no log within LEAF_DECAY_DISTANCE steps through leaves fall
+// off. searching into a chunk that isnt ready keeps them
+static void leavesTick(BlockTicker &ticker, int x, int y, int z)
+{
+    const int size = 2 * LEAF_DECAY_DISTANCE + 1;
+    static const int offsets[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+    struct Node
+    {
+        int8_t x, y, z; // relative to the leaf
+        uint8_t distance;
+    };
+    bool visited[size][size][size];
+    memset(visited, 0, sizeof(visited));
+    std::vector<Node> queue;
+    queue.push_back(Node{0, 0, 0, 0});
+    visited[LEAF_DECAY_DISTANCE][LEAF_DECAY_DISTANCE][LEAF_DECAY_DISTANCE] = true;
+
+    for (size_t i = 0; i < queue.size(); i++)
+    {
+        Node node = queue[i];
+        for (const int *offset : offsets)
+        {
+            int dx = node.x + offset[0], dy = node.y + offset[1], dz = node.z + offset[2];
+            int worldY = y + dy;
+            if (worldY < 0 || worldY >= CHUNK_HEIGHT)
+                continue;
+            bool &seen = visited[dx + LEAF_DECAY_DISTANCE][dy + LEAF_DECAY_DISTANCE][dz + LEAF_DECAY_DISTANCE];
+            if (seen)
+                continue;
+            seen = true;
+
+            int block = ticker.getBlock(x + dx, worldY, z + dz);
+            if (block < 0 || blockType(block) == LOG)
+                return;
+            if (blockType(block) == LEAVES && node.distance + 1 < LEAF_DECAY_DISTANCE)
+                queue.push_back(Node{(int8_t)dx, (int8_t)dy, (int8_t)dz, (uint8_t)(node.distance + 1)});
+        }
+    }
+    ticker.setBlock(x, y, z, AIR);
+}
+
+BlockTicker::BlockTicker(TickWorld world, int workerCount, int budgetMicros, int randomTicksPerSection)
+    : world(std::move(world)), budgetMicros(budgetMicros), randomTicksPerSection(randomTicksPerSection), workers(workerCount, "block ticks")
+{
+}
+
+void BlockTicker::scheduleTick(int x, int y, int z, int delayTicks)
+{
+    if (y < 0 || y >= CHUNK_HEIGHT)
+        return;
+    std::lock_guard<std::mutex> lock(scheduleMutex);
+    if (!scheduledCells.insert(cellKey(x, y, z)).second)
+        return;
+    scheduled.push_back(ScheduledTick{tickCount + delayTicks, scheduleOrder++, x, y, z});
+    std::push_heap(scheduled.begin(), scheduled.end(), std::greater<ScheduledTick>());
+}
+
+// the cells whose rules read the changed one: itself, its 6 neighbors, and
+// the 4 diagonally above it (water there may start or stop spreading onto
+// the side neighbors)
+void BlockTicker::blockChanged(int x, int y, int z)
+{
+    static const int dependents[11][3] = {
+        {0, 0, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+        {1, 1, 0}, {-1, 1, 0}, {0, 1, 1}, {0, 1, -1},
+    };
+    for (const int *offset : dependents)
+    {
+        int cellY = y + offset[1];
+        if (cellY < 0 || cellY >= CHUNK_HEIGHT)
+            continue;
+        int block = world.get(x + offset[0], cellY, z + offset[2]);
+        if (block >= 0 && blockType(block) == WATER)
+            scheduleTick(x + offset[0], cellY, z + offset[2], WATER_FLOW_DELAY);
+    }
+}
+
+void BlockTicker::setBlock(int x, int y, int z, int block)
+{
+    world.set(x, y, z, block);
+    blockChanged(x, y, z);
+}
+
+void BlockTicker::clear()
+{
+    std::lock_guard<std::mutex> lock(scheduleMutex);
+    scheduled.clear();
+    scheduledCells.clear();
+    Metrics::set(METRIC_SCHEDULED_TICKS, 0);
+}
+
+void BlockTicker::tick()
+{
+    tickCount++;
+    uint64_t deadline = Profiler::nowMicros() + budgetMicros;
+    runScheduled(deadline);
+    runRandom(deadline);
+    Metrics::set(METRIC_SCHEDULED_TICKS, (int64_t)scheduled.size());
+}
+
+void BlockTicker::runScheduled(uint64_t deadline)
+{
+    if (scheduled.empty() || scheduled.front().due > tickCount)
+        return;
+
+    PROFILE_SCOPE("scheduledTicks");
+    int run = 0;
+    while (!scheduled.empty() && scheduled.front().due <= tickCount)
+    {
+        // the clock costs more than a tick, look at it every few
+        if (run % 32 == 31 && Profiler::nowMicros() > deadline)
+            break;
+
+        std::pop_heap(scheduled.begin(), scheduled.end(), std::greater<ScheduledTick>());
+        ScheduledTick due = scheduled.back();
+        scheduled.pop_back();
+        scheduledCells.erase(cellKey(due.x, due.y, due.z));
+
+        int block = world.get(due.x, due.y, due.z);
+        if (block >= 0 && blockType(block) == WATER)
+            tickWater(*this, due.x, due.y, due.z);
+        run++;
+    }
+    Metrics::add(METRIC_SCHEDULED_TICKS_RUN, run);
+}
+
+void BlockTicker::randomTickChunk(const TickChunk &chunk)
+{
+    std::mt19937 random((uint32_t)(tickCount * 73856093u) ^ (uint32_t)(chunk.chunkX * 19349663) ^ (uint32_t)(chunk.chunkZ * 83492791));
+    int run = 0;
+    for (int section = 0; section < SECTION_COUNT; section++)
+    {
+        if (!(chunk.sections & (1u << section)))
+            continue;
+        for (int i = 0; i < randomTicksPerSection; i++)
+        {
+            int x = chunk.chunkX * CHUNK_WIDTH + (int)(random() % CHUNK_WIDTH);
+            int y = section * SECTION_HEIGHT + (int)(random() % SECTION_HEIGHT);
+            int z = chunk.chunkZ * CHUNK_WIDTH + (int)(random() % CHUNK_WIDTH);
+            int block = world.get(x, y, z);
+            if (block < 0 || !isRandomTicked(block))
+                continue;
+            if (blockType(block) == GRASS)
+                grassTick(*this, x, y, z, random);
+            else
+                leavesTick(*this, x, y, z);
+            run++;
+        }
+    }
+    Metrics::add(METRIC_RANDOM_TICKS, run);
+}
+
+// the random tick workers wait here for each other between the groups.
+// they were all woken for the tick and a group is short, so they spin a
+// little before going back to sleep, instead of the pool waking them for
+// every group. sleeping still matters with more workers than cores
+struct GroupBarrier
+{
+    const int count;
+    std::atomic<int> arrived{0};
+    std::atomic<int> generation{0};
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    explicit GroupBarrier(int count) : count(count) {}
+
+    void arriveAndWait()
+    {
+        int current = generation.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == count)
+        {
+            arrived.store(0, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                generation.fetch_add(1, std::memory_order_release);
+            }
+            wake.notify_all();
+            return;
+        }
+        for (int spin = 0; spin < 64; spin++)
+        {
+            if (generation.load(std::memory_order_acquire) != current)
+                return;
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this, current] { return generation.load(std::memory_order_acquire) != current; });
+    }
+};
+
+void BlockTicker::runRandom(uint64_t deadline)
+{
+    chunks.clear();
+    world.listChunks(chunks);
+    if (chunks.empty())
+        return;
+
+    PROFILE_SCOPE("randomTicks");
+
+    // the chunks in the order their groups run this tick
+    auto order = [this](const TickChunk &chunk) {
+        int groupX = ((chunk.chunkX % 3) + 3) % 3;
+        int groupZ = ((chunk.chunkZ % 3) + 3) % 3;
+        return (groupX * 3 + groupZ - firstGroup + 9) % 9;
+    };
+    std::stable_sort(chunks.begin(), chunks.end(), [&order](const TickChunk &a, const TickChunk &b) { return order(a) < order(b); });
+    int groupEnds[9];
+    std::atomic<int> groupNext[9];
+    for (int i = 0, index = 0; i < 9; i++)
+    {
+        groupNext[i] = index;
+        while (index < (int)chunks.size() && order(chunks[index]) == i)
+            index++;
+        groupEnds[i] = index;
+    }
+
+    // one job per worker for all the groups, so a tick wakes each worker
+    // once. the first job to see the clock past the deadline stops them all
+    int jobs = std::min(workers.getThreadCount(), (int)chunks.size());
+    GroupBarrier barrier(jobs);
+    std::atomic<int> stoppedGroup(-1);
+    for (int job = 0; job < jobs; job++)
+    {
+        workers.enqueue([this, deadline, &groupEnds, &groupNext, &barrier, &stoppedGroup]() {
+            for (int i = 0; i < 9; i++)
+            {
+                while (stoppedGroup.load(std::memory_order_relaxed) < 0)
+                {
+                    int index = groupNext[i].fetch_add(1, std::memory_order_relaxed);
+                    if (index >= groupEnds[i])
+                        break;
+                    if (Profiler::nowMicros() > deadline)
+                    {
+                        stoppedGroup.store(i, std::memory_order_relaxed);
+                        break;
+                    }
+                    randomTickChunk(chunks[index]);
+                }
+                barrier.arriveAndWait();
+            }
+        });
+    }
+    workers.wait();
+
+    // out of time, the group it ran out in goes first next tick, from its
+    // start, and the skipped ones after it
+    if (stoppedGroup >= 0)
+        firstGroup = (firstGroup + stoppedGroup) % 9;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <unordered_set>
+#include <vector>
+#include "World/Block.hpp"
+#include "Core/ThreadPool.hpp"
+
+// world access of the tick rules. the getter returns -1 where no chunk is
+// ready, rules treat that as a wall they cant see past
+typedef std::function<int(int x, int y, int z)> BlockGetter;
+typedef std::function<void(int x, int y, int z, int block)> BlockSetter;
+
+// a loaded chunk and the sections of it that hold random ticked blocks
+struct TickChunk
+{
+    int chunkX, chunkZ;
+    unsigned int sections;
+};
+
+// what the ticker sees of the world. set is also called from the random
+// tick workers, but never for two chunks closer than 3 apart at once
+struct TickWorld
+{
+    BlockGetter get;
+    BlockSetter set;
+    std::function<void(std::vector<TickChunk> &chunks)> listChunks;
+};
+
+// grass and leaves not placed by the player
+bool isRandomTicked(int block);
+
+// random ticked blocks per section, for the sections bitmask of TickChunk
+void countRandomTicked(const ChunkBlocks &blocks, int counts[SECTION_COUNT]);
+
+// block updates, once per simulation tick:
+//
+// scheduled ticks wait in one priority queue keyed by the tick they are
+// due (water flow). an edit schedules the rules of the blocks around it
+// that depend on it (blockChanged).
+//
+// random ticks sample randomTicksPerSection blocks of every section that
+// holds random ticked blocks (grass spread, leaf decay), skipping the rest
+// of the world. chunks are split in 9 groups by their coordinates mod 3,
+// the chunks of a group are never closer than 3 apart, so a rule reaching
+// into its neighbor chunks never meets another worker. the groups run one
+// after the other, every worker taking chunks of the group until it is
+// done and waiting for the others before the next one.
+//
+// both stop once the tick used budgetMicros (the random ticks look at the
+// clock before every chunk), the rest waits for the next tick. not thread safe, the caller serializes it with the block edits
+// (worldMutex)
+class BlockTicker
+{
+public:
+    BlockTicker(TickWorld world, int workerCount = 2, int budgetMicros = 4000, int randomTicksPerSection = 1);
+
+    BlockTicker(const BlockTicker &) = delete;
+    BlockTicker &operator=(const BlockTicker &) = delete;
+
+    // the block at (x, y, z) was edited, schedules the rules around it
+    void blockChanged(int x, int y, int z);
+
+    // runs the block rule at (x, y, z) delayTicks from now, unless it
+    // already is scheduled
+    void scheduleTick(int x, int y, int z, int delayTicks);
+
+    void tick();
+
+    // forget every scheduled tick, for a world reload
+    void clear();
+
+    // for the rules
+    int getBlock(int x, int y, int z) const { return world.get(x, y, z); }
+    void setBlock(int x, int y, int z, int block);
+
+    size_t getScheduledCount() const { return scheduled.size(); }
+    uint64_t getTickCount() const { return tickCount; }
+
+private:
+    struct ScheduledTick
+    {
+        uint64_t due;
+        uint64_t order; // first scheduled first, among the same due tick
+        int x, y, z;
+
+        bool operator>(const ScheduledTick &other) const
+        {
+            return due != other.due ? due > other.due : order > other.order;
+        }
+    };
+
+    const TickWorld world;
+    const int budgetMicros;
+    const int randomTicksPerSection;
+    uint64_t tickCount = 0;
+    uint64_t scheduleOrder = 0;
+    int firstGroup = 0;
+
+    // min heap on due, the positions in it so nothing is in twice. the
+    // random tick workers schedule too, hence the lock
+    std::mutex scheduleMutex;
+    std::vector<ScheduledTick> scheduled;
+    std::unordered_set<uint64_t> scheduledCells;
+
+    std::vector<TickChunk> chunks;
+    ThreadPool workers;
+
+    void runScheduled(uint64_t deadline);
+    void runRandom(uint64_t deadline);
+    void randomTickChunk(const TickChunk &chunk);
+};
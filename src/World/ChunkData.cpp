@@ -0,0 +1,70 @@
+#include "World/ChunkData.hpp"
+#include "Profiler/Metrics.hpp"
+
+static Metric stateGauge(ChunkState state)
+{
+    switch (state)
+    {
+    case CHUNK_QUEUED:
+        return METRIC_CHUNKS_QUEUED;
+    case CHUNK_GENERATING:
+        return METRIC_CHUNKS_GENERATING;
+    case CHUNK_MESHED:
+        return METRIC_CHUNKS_MESHED;
+    default:
+        return METRIC_CHUNKS_RESIDENT;
+    }
+}
+
+ChunkData::ChunkData(int chunkX, int chunkZ) : chunkX(chunkX), chunkZ(chunkZ)
+{
+    Metrics::increment(stateGauge(CHUNK_QUEUED));
+    Metrics::add(METRIC_BLOCK_BYTES, sizeof(blocks) + sizeof(light));
+}
+
+ChunkData::~ChunkData()
+{
+    Metrics::decrement(stateGauge(getState()));
+    Metrics::add(METRIC_BLOCK_BYTES, -(int64_t)(sizeof(blocks) + sizeof(light)));
+    Metrics::add(METRIC_VERTEX_BYTES, -(int64_t)vertexBytes);
+}
+
+void ChunkData::setState(ChunkState newState)
+{
+    ChunkState oldState = state.exchange(newState, std::memory_order_acq_rel);
+    Metrics::decrement(stateGauge(oldState));
+    Metrics::increment(stateGauge(newState));
+}
+
+void ChunkData::updateVertexBytes()
+{
+    size_t bytes = 0;
+    for (int section = 0; section < SECTION_COUNT; section++)
+        for (int layer = 0; layer < LAYER_COUNT; layer++)
+            bytes += meshes[section].layers[layer].capacity() * sizeof(float);
+    Metrics::add(METRIC_VERTEX_BYTES, (int64_t)bytes - (int64_t)vertexBytes);
+    vertexBytes = bytes;
+}
+
+void ChunkData::publishMesh(int section, SectionMesh &&mesh, uint32_t builtFrom)
+{
+    std::lock_guard<std::mutex> lock(meshMutex);
+    if (builtFrom < newestMeshVersion[section])
+        return;
+
+    pendingMesh[section] = std::move(mesh);
+    hasPendingMesh[section] = true;
+    newestMeshVersion[section] = builtFrom;
+}
+
+bool ChunkData::takeMesh(int section, SectionMesh &mesh)
+{
+    std::lock_guard<std::mutex> lock(meshMutex);
+    if (!hasPendingMesh[section])
+        return false;
+
+    mesh = std::move(pendingMesh[section]);
+    pendingMesh[section] = SectionMesh();
+    hasPendingMesh[section] = false;
+    return true;
+}
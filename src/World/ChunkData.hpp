@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "World/Block.hpp"
+#include "World/Lighting.hpp"
+#include "World/ChunkMesher.hpp"
+
+// where a chunk is in the load pipeline
+enum ChunkState
+{
+    CHUNK_QUEUED,     // waiting for a worker
+    CHUNK_GENERATING, // worker is generating / meshing it
+    CHUNK_MESHED,     // vertices ready, not on the GPU yet
+    CHUNK_UPLOADED,   // on the GPU
+};
+
+// CPU side of a chunk. the render side and the worker job both hold it by
+// shared_ptr, so unloading a chunk mid-generation never frees memory the
+// worker still writes to. keeps the pipeline metrics in sync with its state
+class ChunkData
+{
+public:
+    const int chunkX;
+    const int chunkZ;
+
+    // all the blocks generated in the chunk are stored in this 3d array.
+    // once the chunk is meshed, edits and the autosaver lock blocksMutex
+    ChunkBlocks blocks;
+    std::mutex blocksMutex;
+
+    // computed by the worker after the blocks, kept up to date by edits
+    // (same lock). never saved, loading recomputes it
+    ChunkLight light;
+
+    // random ticked blocks per section (grass, leaves), counted by the
+    // worker and kept up to date by edits, the block ticker only samples
+    // the sections that have some
+    int randomTicked[SECTION_COUNT] = {};
+
+    // one mesh per vertical section
+    SectionMesh meshes[SECTION_COUNT];
+
+    // set when the chunk gets unloaded, a job that hasnt started skips it
+    std::atomic<bool> cancelled{false};
+
+    // sections waiting for a remesh. a job is queued when it goes from 0 to
+    // non zero, so a burst of edits queues only one
+    std::atomic<unsigned int> dirtySections{0};
+
+    ChunkData(int chunkX, int chunkZ);
+    ~ChunkData();
+
+    ChunkState getState() const { return state.load(std::memory_order_acquire); }
+    void setState(ChunkState newState);
+
+    // call after vertices changed so the vertex byte gauge follows
+    void updateVertexBytes();
+
+    // edits bump the version, the saver records the version it wrote. dirty
+    // while they differ
+    uint32_t markEdited() { return version.fetch_add(1, std::memory_order_acq_rel) + 1; }
+    uint32_t getVersion() const { return version.load(std::memory_order_acquire); }
+    void markSaved(uint32_t savedAt) { savedVersion.store(savedAt, std::memory_order_release); }
+    bool isDirty() const { return savedVersion.load(std::memory_order_acquire) != getVersion(); }
+
+    // remeshes after edits. a worker publishes the section mesh built from
+    // some version of the blocks, the render thread takes it whole. an
+    // older mesh finishing late never replaces a newer one
+    void publishMesh(int section, SectionMesh &&mesh, uint32_t builtFrom);
+    bool takeMesh(int section, SectionMesh &mesh);
+
+private:
+    std::mutex meshMutex;
+    SectionMesh pendingMesh[SECTION_COUNT];
+    bool hasPendingMesh[SECTION_COUNT] = {};
+    uint32_t newestMeshVersion[SECTION_COUNT] = {};
+
+    std::atomic<uint32_t> version{0};
+    std::atomic<uint32_t> savedVersion{0};
+
+    std::atomic<ChunkState> state{CHUNK_QUEUED};
+    size_t vertexBytes = 0;
+};
@@ -0,0 +1,542 @@
+#include "World/ChunkMesher.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// x, y, z, u, v, face, type
+static const float localPos[6][6][3] = {
+    {{1.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 0.0f}}, // TOP
+    {{1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}, // BOTTOM
+    {{1.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}}, // FRONT
+    {{0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}}, // BACK
+    {{0.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 1.0f}}, // LEFT
+    {{1.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}}  // RIGHT
+};
+
+// for vertex in each face
+static const float localUv[6][2] = {
+    {1.0f, 1.0f},
+    {0.0f, 1.0f},
+    {0.0f, 0.0f},
+    {0.0f, 0.0f},
+    {1.0f, 0.0f},
+    {1.0f, 1.0f}
+};
+
+RenderLayer blockRenderLayer(int type)
+{
+    switch (type)
+    {
+    case LEAVES:
+        return LAYER_CUTOUT;
+    case WATER:
+        return LAYER_TRANSLUCENT;
+    default:
+        return LAYER_OPAQUE;
+    }
+}
+
+static bool isOpaqueType(int type)
+{
+    return type != AIR && blockRenderLayer(type) == LAYER_OPAQUE;
+}
+
+// one bit per opaque block of a column, bit y + 1 for y = -1..CHUNK_HEIGHT,
+// with an empty border column around the chunk. the face and occlusion
+// lookups then need no bounds checks and never touch the blocks array
+struct Occupancy
+{
+    uint64_t columns[CHUNK_WIDTH + 2][CHUNK_WIDTH + 2];
+};
+static_assert(CHUNK_HEIGHT + 2 <= 64, "an Occupancy column holds CHUNK_HEIGHT + 2 bits, taller chunks need more words per column");
+
+// only the layers fromY - 1 .. toY, all that meshing fromY <= y < toY
+// looks at (faces and occlusion reach one block out), the rest reads as
+// air. a section mesh then doesnt go through the whole chunk
+static void buildOccupancy(const ChunkBlocks &blocks, int fromY, int toY, Occupancy &occupancy)
+{
+    memset(&occupancy, 0, sizeof(occupancy));
+    int bottom = std::max(fromY - 1, 0);
+    int top = std::min(toY + 1, CHUNK_HEIGHT);
+    for (int x = 0; x < CHUNK_WIDTH; x++)
+    {
+        for (int z = 0; z < CHUNK_WIDTH; z++)
+        {
+            uint64_t bits = 0;
+            for (int y = bottom; y < top; y++)
+                bits |= (uint64_t)isOpaqueType(blockType(blocks[x][y][z])) << (y + 1);
+            occupancy.columns[x + 1][z + 1] = bits;
+        }
+    }
+}
+
+// outside the chunk counts as air
+static int isOpaque(const Occupancy &occupancy, int x, int y, int z)
+{
+    return (int)(occupancy.columns[x + 1][z + 1] >> (y + 1)) & 1;
+}
+
+// light in front of a face. above the chunk is open sky. the neighbor
+// chunks' light isnt known here (it doesnt cross chunk sides yet either),
+// so outside a side the cell just inside the chunk stands in for it. that
+// is the block of the face itself, an opaque one has no light of its own:
+// then full sky if nothing opaque is above it in its column, else none
+static float faceLight(const ChunkBlocks &blocks, const ChunkLight &light, int x, int y, int z)
+{
+    if (y < 0)
+        return 0.0f;
+    if (y >= CHUNK_HEIGHT)
+        return (float)packLight(MAX_LIGHT, 0);
+    if (x >= 0 && x < CHUNK_WIDTH && z >= 0 && z < CHUNK_WIDTH)
+        return (float)light[x][y][z];
+
+    int insideX = std::min(std::max(x, 0), CHUNK_WIDTH - 1);
+    int insideZ = std::min(std::max(z, 0), CHUNK_WIDTH - 1);
+    if (!isOpaqueType(blockType(blocks[insideX][y][insideZ])))
+        return (float)light[insideX][y][insideZ];
+    for (int above = y + 1; above < CHUNK_HEIGHT; above++)
+    {
+        if (isOpaqueType(blockType(blocks[insideX][above][insideZ])))
+            return 0.0f;
+    }
+    return (float)packLight(MAX_LIGHT, 0);
+}
+
+static const int faceNormals[6][3] = {
+    {0, 1, 0},  // TOP
+    {0, -1, 0}, // BOTTOM
+    {0, 0, 1},  // FRONT
+    {0, 0, -1}, // BACK
+    {-1, 0, 0}, // LEFT
+    {1, 0, 0},  // RIGHT
+};
+
+// the 4 corners of a face are vertices 0, 1, 2 and 4. the quad is split
+// along corners 0-2, or flipped to split along 1-3
+static const int quadCorners[4] = {0, 1, 2, 4};
+static const int splitTriangles[6] = {0, 1, 2, 2, 3, 0};
+static const int flippedTriangles[6] = {1, 2, 3, 3, 0, 1};
+
+// 0 (both sides blocked) to 3 (open) ambient occlusion of one face corner,
+// from the 3 blocks touching it in the layer in front of the face
+static int cornerOcclusion(const Occupancy &occupancy, FaceDirection face, int x, int y, int z, const float *pos)
+{
+    const int *normal = faceNormals[face];
+    int frontX = x + normal[0], frontY = y + normal[1], frontZ = z + normal[2];
+
+    // step toward the corner along the two axes of the face
+    int stepX = normal[0] != 0 ? 0 : (pos[0] > 0.5f ? 1 : -1);
+    int stepY = normal[1] != 0 ? 0 : (pos[1] > 0.5f ? 1 : -1);
+    int stepZ = normal[2] != 0 ? 0 : (pos[2] > 0.5f ? 1 : -1);
+
+    int side1, side2;
+    if (normal[0] != 0)
+    {
+        side1 = isOpaque(occupancy, frontX, frontY + stepY, frontZ);
+        side2 = isOpaque(occupancy, frontX, frontY, frontZ + stepZ);
+    }
+    else if (normal[1] != 0)
+    {
+        side1 = isOpaque(occupancy, frontX + stepX, frontY, frontZ);
+        side2 = isOpaque(occupancy, frontX, frontY, frontZ + stepZ);
+    }
+    else
+    {
+        side1 = isOpaque(occupancy, frontX + stepX, frontY, frontZ);
+        side2 = isOpaque(occupancy, frontX, frontY + stepY, frontZ);
+    }
+    if (side1 && side2)
+        return 0;
+    return 3 - side1 - side2 - isOpaque(occupancy, frontX + stepX, frontY + stepY, frontZ + stepZ);
+}
+
+// an opaque neighbor hides a face. translucent blocks also hide their faces
+// against the same type, so a pool of water is one surface
+static bool isFaceVisible(const ChunkBlocks &blocks, const Occupancy &occupancy, int type, RenderLayer layer, int x, int y, int z)
+{
+    if (isOpaque(occupancy, x, y, z))
+        return false;
+    if (layer != LAYER_TRANSLUCENT || x < 0 || x >= CHUNK_WIDTH || z < 0 || z >= CHUNK_WIDTH || y < 0 || y >= CHUNK_HEIGHT)
+        return true;
+    return blockType(blocks[x][y][z]) != type;
+}
+
+static void addFace(std::vector<float> &vertices, const Occupancy &occupancy, FaceDirection face, int x, int y, int z, int initialX, int initialZ, int type, float light)
+{
+    int occlusion[4];
+    for (int corner = 0; corner < 4; corner++)
+        occlusion[corner] = cornerOcclusion(occupancy, face, x, y, z, localPos[face][quadCorners[corner]]);
+
+    // split along the brighter diagonal, else a single dark corner bleeds
+    // across the whole quad
+    const int *triangles = occlusion[0] + occlusion[2] < occlusion[1] + occlusion[3] ? flippedTriangles : splitTriangles;
+
+    // add vace vertex to verticies vector
+    for (int vertex = 0; vertex < 6; vertex++)
+    {
+        int corner = triangles[vertex];
+        const float *pos = localPos[face][quadCorners[corner]];
+        const float *uv = localUv[quadCorners[corner]];
+
+        vertices.push_back(pos[0] + x + initialX);
+        vertices.push_back(pos[1] + y);
+        vertices.push_back(pos[2] + z + initialZ);
+
+        vertices.push_back(uv[0]);
+        vertices.push_back(uv[1]);
+
+        vertices.push_back(static_cast<float>(face)); // for face of block texture
+        vertices.push_back(static_cast<float>(type)); // for block texture
+        vertices.push_back(light);
+        vertices.push_back(static_cast<float>(occlusion[corner]));
+    }
+}
+
+// the solid run from fromY up in every column of a cell, capped at toY
+static void findOccluders(const Occupancy &occupancy, int fromY, int toY, SectionMesh &mesh)
+{
+    for (int cellX = 0; cellX < OCCLUDER_CELLS; cellX++)
+    {
+        for (int cellZ = 0; cellZ < OCCLUDER_CELLS; cellZ++)
+        {
+            int run = toY - fromY;
+            for (int x = cellX * OCCLUDER_CELL; x < (cellX + 1) * OCCLUDER_CELL; x++)
+            {
+                for (int z = cellZ * OCCLUDER_CELL; z < (cellZ + 1) * OCCLUDER_CELL; z++)
+                {
+                    // count the opaque bits from fromY up, the first clear one ends the run
+                    uint64_t bits = occupancy.columns[x + 1][z + 1] >> (fromY + 1);
+                    int opaque = 0;
+                    while (opaque < run && (bits >> opaque & 1))
+                        opaque++;
+                    run = opaque;
+                }
+            }
+            mesh.occluderHeights[cellX][cellZ] = (uint8_t)run;
+        }
+    }
+}
+
+// flood fills the blocks with fromY <= y < toY that arent opaque, every
+// region connects all the sides it touches
+static void findFaceConnections(const Occupancy &occupancy, int fromY, int toY, SectionMesh &mesh)
+{
+    int layers = toY - fromY;
+    std::vector<uint8_t> visited(CHUNK_WIDTH * layers * CHUNK_WIDTH, 0);
+    std::vector<int> stack;
+    for (int start = 0; start < (int)visited.size(); start++)
+    {
+        if (visited[start] || isOpaque(occupancy, start / (layers * CHUNK_WIDTH), fromY + start / CHUNK_WIDTH % layers, start % CHUNK_WIDTH))
+            continue;
+
+        unsigned int sides = 0;
+        visited[start] = 1;
+        stack.push_back(start);
+        while (!stack.empty())
+        {
+            int cell = stack.back();
+            stack.pop_back();
+            int x = cell / (layers * CHUNK_WIDTH), y = cell / CHUNK_WIDTH % layers, z = cell % CHUNK_WIDTH;
+            if (y == layers - 1)
+                sides |= 1u << TOP;
+            if (y == 0)
+                sides |= 1u << BOTTOM;
+            if (z == CHUNK_WIDTH - 1)
+                sides |= 1u << FRONT;
+            if (z == 0)
+                sides |= 1u << BACK;
+            if (x == 0)
+                sides |= 1u << LEFT;
+            if (x == CHUNK_WIDTH - 1)
+                sides |= 1u << RIGHT;
+
+            for (const int *normal : faceNormals)
+            {
+                int nextX = x + normal[0], nextY = y + normal[1], nextZ = z + normal[2];
+                if (nextX < 0 || nextX >= CHUNK_WIDTH || nextY < 0 || nextY >= layers || nextZ < 0 || nextZ >= CHUNK_WIDTH)
+                    continue;
+                int next = (nextX * layers + nextY) * CHUNK_WIDTH + nextZ;
+                if (visited[next] || isOpaque(occupancy, nextX, fromY + nextY, nextZ))
+                    continue;
+                visited[next] = 1;
+                stack.push_back(next);
+            }
+        }
+
+        for (int side = 0; side < 6; side++)
+        {
+            if (sides & (1u << side))
+                mesh.faceConnections[side] |= (uint8_t)sides;
+        }
+    }
+}
+
+// appends the faces of the blocks with fromY <= y < toY
+static void meshLayers(const ChunkBlocks &blocks, const ChunkLight &light, int fromY, int toY, int initialX, int initialZ, SectionMesh &mesh)
+{
+    Occupancy occupancy;
+    buildOccupancy(blocks, fromY, toY, occupancy);
+    findOccluders(occupancy, fromY, toY, mesh);
+    findFaceConnections(occupancy, fromY, toY, mesh);
+
+    for (int x = 0; x < CHUNK_WIDTH; x++)
+    {
+        for (int y = fromY; y < toY; y++)
+        {
+            for (int z = 0; z < CHUNK_WIDTH; z++)
+            {
+                int type = blockType(blocks[x][y][z]);
+                if (type == AIR)
+                    continue;
+                RenderLayer layer = blockRenderLayer(type);
+                std::vector<float> &vertices = mesh.layers[layer];
+
+                // add each exposed face if block is not air
+                if (isFaceVisible(blocks, occupancy, type, layer, x, y + 1, z))
+                    addFace(vertices, occupancy, TOP, x, y, z, initialX, initialZ, type, faceLight(blocks, light, x, y + 1, z)); // add top face
+                if (isFaceVisible(blocks, occupancy, type, layer, x, y - 1, z))
+                    addFace(vertices, occupancy, BOTTOM, x, y, z, initialX, initialZ, type, faceLight(blocks, light, x, y - 1, z)); // add bottom face
+                if (isFaceVisible(blocks, occupancy, type, layer, x + 1, y, z))
+                    addFace(vertices, occupancy, RIGHT, x, y, z, initialX, initialZ, type, faceLight(blocks, light, x + 1, y, z)); // add right face
+                if (isFaceVisible(blocks, occupancy, type, layer, x - 1, y, z))
+                    addFace(vertices, occupancy, LEFT, x, y, z, initialX, initialZ, type, faceLight(blocks, light, x - 1, y, z)); // add left face
+                if (isFaceVisible(blocks, occupancy, type, layer, x, y, z + 1))
+                    addFace(vertices, occupancy, FRONT, x, y, z, initialX, initialZ, type, faceLight(blocks, light, x, y, z + 1)); // add front face
+                if (isFaceVisible(blocks, occupancy, type, layer, x, y, z - 1))
+                    addFace(vertices, occupancy, BACK, x, y, z, initialX, initialZ, type, faceLight(blocks, light, x, y, z - 1)); // add back face
+            }
+        }
+    }
+}
+
+void buildChunkMesh(const ChunkBlocks &blocks, const ChunkLight &light, int initialX, int initialZ, SectionMesh &mesh)
+{
+    mesh.clear();
+    meshLayers(blocks, light, 0, CHUNK_HEIGHT, initialX, initialZ, mesh);
+}
+
+void buildSectionMesh(const ChunkBlocks &blocks, const ChunkLight &light, int section, int initialX, int initialZ, SectionMesh &mesh)
+{
+    mesh.clear();
+    meshLayers(blocks, light, section * SECTION_HEIGHT, (section + 1) * SECTION_HEIGHT, initialX, initialZ, mesh);
+}
+
+void chunkOccluderHeights(const uint8_t sections[SECTION_COUNT][OCCLUDER_CELLS][OCCLUDER_CELLS], int heights[OCCLUDER_CELLS * OCCLUDER_CELLS])
+{
+    for (int cellX = 0; cellX < OCCLUDER_CELLS; cellX++)
+    {
+        for (int cellZ = 0; cellZ < OCCLUDER_CELLS; cellZ++)
+        {
+            int height = 0;
+            for (int section = 0; section < SECTION_COUNT; section++)
+            {
+                height += sections[section][cellX][cellZ];
+                if (sections[section][cellX][cellZ] < SECTION_HEIGHT)
+                    break;
+            }
+            heights[cellX * OCCLUDER_CELLS + cellZ] = height;
+        }
+    }
+}
+
+unsigned int sectionsTouchedBy(int y)
+{
+    int section = y / SECTION_HEIGHT;
+    unsigned int mask = 1u << section;
+    if (y % SECTION_HEIGHT == 0 && section > 0)
+        mask |= 1u << (section - 1);
+    if (y % SECTION_HEIGHT == SECTION_HEIGHT - 1 && section < SECTION_COUNT - 1)
+        mask |= 1u << (section + 1);
+    return mask;
+}
+
+// a face of the box of size x size x height at (x, y, z), lit and
+// unoccluded, for the level of detail meshes. the quad split doesnt matter
+// without occlusion
+static void addBoxFace(std::vector<float> &vertices, FaceDirection face, float x, float y, float z, float size, float height, int type, float light)
+{
+    for (int vertex = 0; vertex < 6; vertex++)
+    {
+        const float *pos = localPos[face][vertex];
+        vertices.push_back(x + pos[0] * size);
+        vertices.push_back(y + pos[1] * height);
+        vertices.push_back(z + pos[2] * size);
+
+        vertices.push_back(localUv[vertex][0]);
+        vertices.push_back(localUv[vertex][1]);
+
+        vertices.push_back(static_cast<float>(face));
+        vertices.push_back(static_cast<float>(type));
+        vertices.push_back(light);
+        vertices.push_back(3.0f);
+    }
+}
+
+// what a level of detail cell becomes, AIR if mostly empty
+static int lodCellType(const ChunkBlocks &blocks, int cellX, int cellY, int cellZ, int scale)
+{
+    int solid = 0, water = 0;
+    int topCounts[1 << BLOCK_TYPE_BITS] = {};
+    for (int x = cellX * scale; x < (cellX + 1) * scale; x++)
+    {
+        for (int z = cellZ * scale; z < (cellZ + 1) * scale; z++)
+        {
+            // the top type also looks into the cell above, a surface in a
+            // mostly empty cell is still what shows from above
+            int top = AIR;
+            for (int y = std::min((cellY + 2) * scale, CHUNK_HEIGHT) - 1; y >= cellY * scale; y--)
+            {
+                int type = blockType(blocks[x][y][z]);
+                if (top == AIR && type != AIR && type != WATER)
+                    top = type;
+                if (y >= (cellY + 1) * scale)
+                    continue;
+                if (type == WATER)
+                    water++;
+                else if (type != AIR)
+                    solid++;
+            }
+            topCounts[top]++;
+        }
+    }
+
+    int half = scale * scale * scale / 2;
+    if (solid >= half)
+    {
+        int best = STONE;
+        for (int type = AIR + 1; type < (1 << BLOCK_TYPE_BITS); type++)
+        {
+            if (type != WATER && topCounts[type] > topCounts[best])
+                best = type;
+        }
+        return best;
+    }
+    return water >= half ? WATER : AIR;
+}
+
+void buildLodMesh(const ChunkBlocks &blocks, int scale, int initialX, int initialZ, SectionMesh &mesh)
+{
+    const int cellsWide = CHUNK_WIDTH / scale;
+    const int cellsHigh = CHUNK_HEIGHT / scale;
+    std::vector<int> cells(cellsWide * cellsHigh * cellsWide);
+    auto cellAt = [&](int x, int y, int z) -> int
+    {
+        // outside the chunk is air, above and on the sides
+        if (x < 0 || x >= cellsWide || y >= cellsHigh || z < 0 || z >= cellsWide)
+            return AIR;
+        if (y < 0)
+            return BEDROCK;
+        return cells[(x * cellsHigh + y) * cellsWide + z];
+    };
+    for (int x = 0; x < cellsWide; x++)
+        for (int y = 0; y < cellsHigh; y++)
+            for (int z = 0; z < cellsWide; z++)
+                cells[(x * cellsHigh + y) * cellsWide + z] = lodCellType(blocks, x, y, z, scale);
+
+    mesh.clear();
+    const float light = (float)packLight(MAX_LIGHT, 0);
+    for (int x = 0; x < cellsWide; x++)
+    {
+        for (int y = 0; y < cellsHigh; y++)
+        {
+            for (int z = 0; z < cellsWide; z++)
+            {
+                int type = cellAt(x, y, z);
+                if (type == AIR)
+                    continue;
+                RenderLayer layer = blockRenderLayer(type);
+                std::vector<float> &vertices = mesh.layers[layer];
+
+                for (int face = 0; face < 6; face++)
+                {
+                    const int *normal = faceNormals[face];
+                    int neighbor = cellAt(x + normal[0], y + normal[1], z + normal[2]);
+                    if (isOpaqueType(neighbor) || (layer == LAYER_TRANSLUCENT && neighbor == type))
+                        continue;
+
+                    addBoxFace(vertices, (FaceDirection)face, (float)(x * scale + initialX), (float)(y * scale), (float)(z * scale + initialZ), (float)scale, (float)scale, type, light);
+                }
+            }
+        }
+    }
+}
+
+void computeHeightmap(const ChunkBlocks &blocks, ChunkHeightmap &map)
+{
+    for (int x = 0; x < CHUNK_WIDTH; x++)
+    {
+        for (int z = 0; z < CHUNK_WIDTH; z++)
+        {
+            int y = CHUNK_HEIGHT - 1;
+            while (y >= 0 && blockType(blocks[x][y][z]) == AIR)
+                y--;
+            map.height[x][z] = y;
+            map.top[x][z] = y >= 0 ? blockType(blocks[x][y][z]) : AIR;
+        }
+    }
+}
+
+void buildHeightfieldMesh(const ChunkHeightmap &map, int scale, int initialX, int initialZ, SectionMesh &mesh)
+{
+    const int cellsWide = CHUNK_WIDTH / scale;
+    std::vector<int> heights(cellsWide * cellsWide), types(cellsWide * cellsWide);
+    for (int cellX = 0; cellX < cellsWide; cellX++)
+    {
+        for (int cellZ = 0; cellZ < cellsWide; cellZ++)
+        {
+            int sum = 0;
+            int topCounts[1 << BLOCK_TYPE_BITS] = {};
+            for (int x = cellX * scale; x < (cellX + 1) * scale; x++)
+            {
+                for (int z = cellZ * scale; z < (cellZ + 1) * scale; z++)
+                {
+                    sum += map.height[x][z];
+                    topCounts[map.top[x][z]]++;
+                }
+            }
+            int best = AIR;
+            for (int type = AIR; type < (1 << BLOCK_TYPE_BITS); type++)
+            {
+                if (topCounts[type] > topCounts[best])
+                    best = type;
+            }
+            int columns = scale * scale;
+            heights[cellX * cellsWide + cellZ] = (int)std::floor((float)sum / columns + 0.5f);
+            types[cellX * cellsWide + cellZ] = best;
+        }
+    }
+
+    mesh.clear();
+    const float light = (float)packLight(MAX_LIGHT, 0);
+    const FaceDirection sides[4] = {FRONT, BACK, LEFT, RIGHT};
+    for (int cellX = 0; cellX < cellsWide; cellX++)
+    {
+        for (int cellZ = 0; cellZ < cellsWide; cellZ++)
+        {
+            int height = heights[cellX * cellsWide + cellZ];
+            int type = types[cellX * cellsWide + cellZ];
+            if (height < 0 || type == AIR)
+                continue;
+            std::vector<float> &vertices = mesh.layers[blockRenderLayer(type)];
+            float x = (float)(cellX * scale + initialX);
+            float z = (float)(cellZ * scale + initialZ);
+
+            // the top of the cell's blocks, they span y 0..height + 1
+            addBoxFace(vertices, TOP, x, 0.0f, z, (float)scale, (float)(height + 1), type, light);
+
+            for (FaceDirection face : sides)
+            {
+                int neighborX = cellX + faceNormals[face][0];
+                int neighborZ = cellZ + faceNormals[face][2];
+                int neighborHeight = -1; // the skirt, past the chunk border
+                if (neighborX >= 0 && neighborX < cellsWide && neighborZ >= 0 && neighborZ < cellsWide)
+                    neighborHeight = heights[neighborX * cellsWide + neighborZ];
+                if (neighborHeight >= height)
+                    continue;
+                addBoxFace(vertices, face, x, (float)(neighborHeight + 1), z, (float)scale, (float)(height - neighborHeight), type, light);
+            }
+        }
+    }
+}
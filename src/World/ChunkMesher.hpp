@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "World/Block.hpp"
+#include "World/Lighting.hpp"
+
+// x, y, z, u, v, face, type, light (packed sky / block nibbles, 0..255),
+// ambient occlusion (0 fully occluded .. 3 open)
+const int VERTEX_FLOATS = 9;
+
+enum FaceDirection
+{
+    TOP,
+    BOTTOM,
+    FRONT,
+    BACK,
+    LEFT,
+    RIGHT,
+};
+
+// how the faces of a block type are drawn, one pass per layer
+enum RenderLayer
+{
+    LAYER_OPAQUE,      // depth tested and written, no blending
+    LAYER_CUTOUT,      // same, transparent texels discarded (leaves)
+    LAYER_TRANSLUCENT, // blended after the rest, back to front (water)
+    LAYER_COUNT,
+};
+
+RenderLayer blockRenderLayer(int type);
+
+// occluders are counted per cell of OCCLUDER_CELL x OCCLUDER_CELL columns
+const int OCCLUDER_CELL = 4;
+const int OCCLUDER_CELLS = CHUNK_WIDTH / OCCLUDER_CELL;
+
+// the vertices of a section (or a whole column), one array per layer
+struct SectionMesh
+{
+    std::vector<float> layers[LAYER_COUNT];
+
+    // how many layers from the bottom of the mesh are opaque in every
+    // column of a cell, so the box of the cell that high is solid all the
+    // way through, an occluder (see OcclusionCuller)
+    uint8_t occluderHeights[OCCLUDER_CELLS][OCCLUDER_CELLS] = {};
+
+    // for each side of the mesh (FaceDirection), a bit per side reachable
+    // from it through blocks that arent opaque, for SectionGraph
+    uint8_t faceConnections[6] = {};
+
+    size_t floatCount() const
+    {
+        size_t count = 0;
+        for (int layer = 0; layer < LAYER_COUNT; layer++)
+            count += layers[layer].size();
+        return count;
+    }
+
+    void clear()
+    {
+        for (int layer = 0; layer < LAYER_COUNT; layer++)
+            layers[layer].clear();
+        memset(occluderHeights, 0, sizeof(occluderHeights));
+        memset(faceConnections, 0, sizeof(faceConnections));
+    }
+};
+
+// builds the vertices of every exposed face of the chunk (world space,
+// 6 vertices per face), split by layer. only opaque blocks hide faces. a
+// face gets the light of the block in front of it (on the chunk's sides,
+// an estimate from the chunk's own border), each corner the occlusion of
+// the blocks around it in that layer. no GL, so it runs on workers and
+// headless tools
+void buildChunkMesh(const ChunkBlocks &blocks, const ChunkLight &light, int initialX, int initialZ, SectionMesh &mesh);
+
+// same, only for the blocks of one vertical section. faces against the
+// sections above and below are culled like any other
+void buildSectionMesh(const ChunkBlocks &blocks, const ChunkLight &light, int section, int initialX, int initialZ, SectionMesh &mesh);
+
+// the occluder heights of the sections of a chunk, bottom up, as one solid
+// column per cell from the bottom of the chunk: a section only adds to it
+// while the ones below are solid all the way up. heights[x * OCCLUDER_CELLS
+// + z], for OcclusionCuller::addOccluderHeightfield
+void chunkOccluderHeights(const uint8_t sections[SECTION_COUNT][OCCLUDER_CELLS][OCCLUDER_CELLS], int heights[OCCLUDER_CELLS * OCCLUDER_CELLS]);
+
+// coarse mesh of a distant chunk: every cell of scale x scale x scale blocks
+// (scale 2, 4 or 8) becomes one big block. a cell at least half solid is
+// solid, with the type most of its columns show on top, else water if at
+// least half water. no light or occlusion, distant faces get full sky.
+// faces on the chunk border are always kept, they close the seams against
+// neighbors of another detail level like a skirt
+void buildLodMesh(const ChunkBlocks &blocks, int scale, int initialX, int initialZ, SectionMesh &mesh);
+
+// the surface of full blocks, for tiles of chunks that have them (saved)
+void computeHeightmap(const ChunkBlocks &blocks, ChunkHeightmap &map);
+
+// coarser still, for the furthest tiles: every cell of scale x scale
+// columns is one flat top at the mean height of its columns, with the type
+// most of them show, and walls down to lower neighbor cells. the walls on
+// the chunk border reach down to the bottom, the skirt closing the seams
+void buildHeightfieldMesh(const ChunkHeightmap &map, int scale, int initialX, int initialZ, SectionMesh &mesh);
+
+// bitmask of the sections whose mesh can change when the block at y does:
+// its own, plus the one across a section border it touches
+unsigned int sectionsTouchedBy(int y);
@@ -0,0 +1,85 @@
+#include "World/FluidSimulation.hpp"
+
+static const int horizontal[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+static bool isWater(int block)
+{
+    return block >= 0 && blockType(block) == WATER;
+}
+
+// level of the water a block spreads sideways, sources and water landing
+// from above spread the farthest. -1 if it doesnt
+static int spreadLevel(int block)
+{
+    int level = blockLevel(block);
+    if (level == WATER_SOURCE || level == WATER_FALLING)
+        return 1;
+    return level < WATER_MAX_FLOW ? level + 1 : -1;
+}
+
+// sources always spread to their sides, other water only once it cant
+// fall any further: resting on a block, or on water that is flowing
+static bool spreadsSideways(const BlockTicker &ticker, int x, int y, int z, int level)
+{
+    if (level == WATER_SOURCE || y == 0)
+        return true;
+    int below = ticker.getBlock(x, y - 1, z);
+    if (below == AIR)
+        return false;
+    if (isWater(below) && (blockLevel(below) == WATER_SOURCE || blockLevel(below) == WATER_FALLING))
+        return false;
+    return true;
+}
+
+void tickWater(BlockTicker &ticker, int x, int y, int z)
+{
+    int block = ticker.getBlock(x, y, z);
+    if (!isWater(block))
+        return;
+
+    int level = blockLevel(block);
+    if (level != WATER_SOURCE)
+    {
+        int fed = -1;
+        if (y + 1 < CHUNK_HEIGHT && isWater(ticker.getBlock(x, y + 1, z)))
+        {
+            fed = WATER_FALLING;
+        }
+        else
+        {
+            for (const int *step : horizontal)
+            {
+                int neighborX = x + step[0], neighborZ = z + step[1];
+                int neighbor = ticker.getBlock(neighborX, y, neighborZ);
+                if (!isWater(neighbor) || !spreadsSideways(ticker, neighborX, y, neighborZ, blockLevel(neighbor)))
+                    continue;
+                int spread = spreadLevel(neighbor);
+                if (spread > 0 && (fed < 0 || spread < fed))
+                    fed = spread;
+            }
+        }
+
+        if (fed < 0)
+        {
+            ticker.setBlock(x, y, z, AIR);
+            return;
+        }
+        if (fed != level)
+        {
+            ticker.setBlock(x, y, z, makeBlock(WATER, fed));
+            level = fed;
+        }
+    }
+
+    if (y > 0 && ticker.getBlock(x, y - 1, z) == AIR)
+        ticker.setBlock(x, y - 1, z, makeBlock(WATER, WATER_FALLING));
+
+    int spread = spreadLevel(makeBlock(WATER, level));
+    if (spread < 0 || !spreadsSideways(ticker, x, y, z, level))
+        return;
+    for (const int *step : horizontal)
+    {
+        if (ticker.getBlock(x + step[0], y, z + step[1]) == AIR)
+            ticker.setBlock(x + step[0], y, z + step[1], makeBlock(WATER, spread));
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "World/BlockTicks.hpp"
+
+// ticks between a water cell changing and it flowing on
+const int WATER_FLOW_DELAY = 10;
+
+// scheduled tick of a water cell, a cellular automaton step. a source
+// stays as it is, any other water takes the level its neighbors feed it
+// (falling while there is water above, else one weaker than the strongest
+// neighbor spreading sideways) and dries up without one. then water runs
+// down into air, and spreads sideways into air where it does. every write
+// goes through the ticker, which schedules the water around it
+void tickWater(BlockTicker &ticker, int x, int y, int z);
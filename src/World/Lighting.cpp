@@ -0,0 +1,226 @@
+#include "World/Lighting.hpp"
+
+#include <cstddef>
+#include <vector>
+
+int blockLightEmission(int block)
+{
+    (void)block;
+    return 0;
+}
+
+int blockLightOpacity(int block)
+{
+    switch (blockType(block))
+    {
+    case AIR:
+        return 0;
+    case LEAVES:
+        return 1;
+    case WATER:
+        return 2;
+    default:
+        return MAX_LIGHT;
+    }
+}
+
+namespace
+{
+struct LightNode
+{
+    int8_t x, y, z;
+    uint8_t level;
+};
+
+const int SKY = 0;
+const int BLOCK = 1;
+
+const int offsets[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+int getLevel(const ChunkLight &light, int channel, int x, int y, int z)
+{
+    return channel == SKY ? skyLight(light[x][y][z]) : blockLight(light[x][y][z]);
+}
+
+void setLevel(ChunkLight &light, int channel, int x, int y, int z, int level)
+{
+    uint8_t &packed = light[x][y][z];
+    packed = channel == SKY ? packLight(level, blockLight(packed)) : packLight(skyLight(packed), level);
+}
+
+bool inChunk(int x, int y, int z)
+{
+    return x >= 0 && x < CHUNK_WIDTH && y >= 0 && y < CHUNK_HEIGHT && z >= 0 && z < CHUNK_WIDTH;
+}
+
+// level the light of a neighbor at `level` has after stepping into a
+// block, sky light going straight down through air doesnt fade
+int spreadLevel(int channel, int level, int type, int dy)
+{
+    int opacity = blockLightOpacity(type);
+    if (opacity >= MAX_LIGHT)
+        return 0;
+    if (channel == SKY && level == MAX_LIGHT && dy == -1 && opacity == 0)
+        return MAX_LIGHT;
+    int result = level - 1 - opacity;
+    return result > 0 ? result : 0;
+}
+
+// bfs from every node in the queue into darker neighbors
+void propagate(const ChunkBlocks &blocks, ChunkLight &light, int channel, std::vector<LightNode> &queue, unsigned int &changed)
+{
+    for (size_t i = 0; i < queue.size(); i++)
+    {
+        LightNode node = queue[i];
+        // a later removal may have darkened it meanwhile
+        if (getLevel(light, channel, node.x, node.y, node.z) != node.level)
+            continue;
+
+        for (const int *offset : offsets)
+        {
+            int nx = node.x + offset[0], ny = node.y + offset[1], nz = node.z + offset[2];
+            if (!inChunk(nx, ny, nz))
+                continue;
+            int level = spreadLevel(channel, node.level, blocks[nx][ny][nz], offset[1]);
+            if (level > getLevel(light, channel, nx, ny, nz))
+            {
+                setLevel(light, channel, nx, ny, nz, level);
+                changed |= 1u << (ny / SECTION_HEIGHT);
+                queue.push_back(LightNode{(int8_t)nx, (int8_t)ny, (int8_t)nz, (uint8_t)level});
+            }
+        }
+    }
+    queue.clear();
+}
+
+// darkens everything that got its light from the removed nodes, and queues
+// the brighter border of the dark area to flood back in
+void unpropagate(const ChunkBlocks &blocks, ChunkLight &light, int channel, std::vector<LightNode> &removal, std::vector<LightNode> &refill, unsigned int &changed)
+{
+    for (size_t i = 0; i < removal.size(); i++)
+    {
+        LightNode node = removal[i];
+        for (const int *offset : offsets)
+        {
+            int nx = node.x + offset[0], ny = node.y + offset[1], nz = node.z + offset[2];
+            if (!inChunk(nx, ny, nz))
+                continue;
+            int level = getLevel(light, channel, nx, ny, nz);
+            if (level == 0)
+                continue;
+
+            // lit by the removed node: below it, or the sky column under it
+            bool fromNode = level < node.level || (channel == SKY && offset[1] == -1 && node.level == MAX_LIGHT && level == MAX_LIGHT);
+            if (fromNode)
+            {
+                setLevel(light, channel, nx, ny, nz, 0);
+                changed |= 1u << (ny / SECTION_HEIGHT);
+                removal.push_back(LightNode{(int8_t)nx, (int8_t)ny, (int8_t)nz, (uint8_t)level});
+
+                // a light source in the dark area shines again
+                int emission = channel == BLOCK ? blockLightEmission(blocks[nx][ny][nz]) : 0;
+                if (emission > 0)
+                {
+                    setLevel(light, channel, nx, ny, nz, emission);
+                    refill.push_back(LightNode{(int8_t)nx, (int8_t)ny, (int8_t)nz, (uint8_t)emission});
+                }
+            }
+            else
+            {
+                refill.push_back(LightNode{(int8_t)nx, (int8_t)ny, (int8_t)nz, (uint8_t)level});
+            }
+        }
+    }
+    removal.clear();
+}
+} // namespace
+
+void computeChunkLight(const ChunkBlocks &blocks, ChunkLight &light)
+{
+    std::vector<LightNode> queue;
+    queue.reserve(CHUNK_WIDTH * CHUNK_WIDTH * 4);
+    unsigned int changed = 0;
+
+    // sky: full light down each column until something stops it
+    for (int x = 0; x < CHUNK_WIDTH; x++)
+    {
+        for (int z = 0; z < CHUNK_WIDTH; z++)
+        {
+            int level = MAX_LIGHT; // above the chunk
+            for (int y = CHUNK_HEIGHT - 1; y >= 0; y--)
+            {
+                int type = blocks[x][y][z];
+                level = spreadLevel(SKY, level, type, -1);
+                light[x][y][z] = packLight(level, blockLightEmission(type));
+            }
+        }
+    }
+
+    // then sideways (and into overhangs), seeded from every lit block next
+    // to a darker one
+    for (int channel = SKY; channel <= BLOCK; channel++)
+    {
+        for (int x = 0; x < CHUNK_WIDTH; x++)
+        {
+            for (int y = 0; y < CHUNK_HEIGHT; y++)
+            {
+                for (int z = 0; z < CHUNK_WIDTH; z++)
+                {
+                    int level = getLevel(light, channel, x, y, z);
+                    if (level > 1)
+                        queue.push_back(LightNode{(int8_t)x, (int8_t)y, (int8_t)z, (uint8_t)level});
+                }
+            }
+        }
+        propagate(blocks, light, channel, queue, changed);
+    }
+}
+
+unsigned int updateLightAfterEdit(const ChunkBlocks &blocks, ChunkLight &light, int x, int y, int z)
+{
+    unsigned int changed = 0;
+    int newType = blocks[x][y][z];
+    std::vector<LightNode> removal, refill;
+
+    for (int channel = SKY; channel <= BLOCK; channel++)
+    {
+        // 1. take out the light the block had, and everything it fed
+        int oldLevel = getLevel(light, channel, x, y, z);
+        if (oldLevel > 0)
+        {
+            setLevel(light, channel, x, y, z, 0);
+            changed |= 1u << (y / SECTION_HEIGHT);
+            removal.push_back(LightNode{(int8_t)x, (int8_t)y, (int8_t)z, (uint8_t)oldLevel});
+            unpropagate(blocks, light, channel, removal, refill, changed);
+        }
+
+        // 2. the block itself: its own emission, the open sky above it, or
+        // whatever its neighbors shine into it
+        int level = channel == BLOCK ? blockLightEmission(newType) : 0;
+        if (channel == SKY)
+        {
+            int above = y + 1 < CHUNK_HEIGHT ? getLevel(light, SKY, x, y + 1, z) : MAX_LIGHT;
+            level = spreadLevel(SKY, above, newType, -1);
+        }
+        for (const int *offset : offsets)
+        {
+            int nx = x + offset[0], ny = y + offset[1], nz = z + offset[2];
+            if (inChunk(nx, ny, nz))
+            {
+                int fromNeighbor = spreadLevel(channel, getLevel(light, channel, nx, ny, nz), newType, -offset[1]);
+                level = fromNeighbor > level ? fromNeighbor : level;
+            }
+        }
+        if (level > 0)
+        {
+            setLevel(light, channel, x, y, z, level);
+            changed |= 1u << (y / SECTION_HEIGHT);
+            refill.push_back(LightNode{(int8_t)x, (int8_t)y, (int8_t)z, (uint8_t)level});
+        }
+
+        // 3. flood back into the dark area from its lit border
+        propagate(blocks, light, channel, refill, changed);
+    }
+
+    return changed;
+}
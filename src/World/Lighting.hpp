@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include "World/Block.hpp"
+
+const int MAX_LIGHT = 15;
+
+// light of every block of a chunk, one byte each: sky light in the high
+// nibble, block light in the low one, 0..MAX_LIGHT both
+typedef uint8_t ChunkLight[CHUNK_WIDTH][CHUNK_HEIGHT][CHUNK_WIDTH];
+
+inline int skyLight(uint8_t packed) { return packed >> 4; }
+inline int blockLight(uint8_t packed) { return packed & 0xF; }
+inline uint8_t packLight(int sky, int block) { return (uint8_t)((sky << 4) | block); }
+
+// light a block gives off. no block type emits yet, the block light
+// channel is there for when one does
+int blockLightEmission(int block);
+
+// how much light a block eats on top of the 1 per step, MAX_LIGHT stops it
+int blockLightOpacity(int block);
+
+// full light of a chunk: sky light straight down every column from above
+// the chunk, then both channels flood filled. light doesnt cross chunk
+// sides yet
+void computeChunkLight(const ChunkBlocks &blocks, ChunkLight &light);
+
+// after blocks[x][y][z] changed, fixes the light around it with removal /
+// add queues instead of recomputing the chunk. ends up exactly where
+// computeChunkLight would. returns the bitmask of sections whose light
+// changed
+unsigned int updateLightAfterEdit(const ChunkBlocks &blocks, ChunkLight &light, int x, int y, int z);
@@ -0,0 +1,125 @@
+#include "World/Raycast.hpp"
+
+#include <cmath>
+#include <limits>
+
+// per axis setup: the step direction, the ray distance between two block
+// borders, and the distance to the first border
+static void initAxis(float origin, float dir, int cell, int &step, float &tDelta, float &tMax)
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+    if (dir > 0.0f)
+    {
+        step = 1;
+        tDelta = 1.0f / dir;
+        tMax = (cell + 1 - origin) / dir;
+    }
+    else if (dir < 0.0f)
+    {
+        step = -1;
+        tDelta = -1.0f / dir;
+        tMax = (origin - cell) / -dir;
+    }
+    else
+    {
+        step = 0;
+        tDelta = infinity;
+        tMax = infinity;
+    }
+}
+
+bool raycastBlocks(const ChunkLookup &lookup, float originX, float originY, float originZ,
+                   float dirX, float dirY, float dirZ, float maxDistance, RaycastHit &hit)
+{
+    float length = std::sqrt(dirX * dirX + dirY * dirY + dirZ * dirZ);
+    if (length == 0.0f)
+        return false;
+    dirX /= length;
+    dirY /= length;
+    dirZ /= length;
+
+    int x = (int)std::floor(originX);
+    int y = (int)std::floor(originY);
+    int z = (int)std::floor(originZ);
+
+    int stepX, stepY, stepZ;
+    float tDeltaX, tDeltaY, tDeltaZ;
+    float tMaxX, tMaxY, tMaxZ;
+    initAxis(originX, dirX, x, stepX, tDeltaX, tMaxX);
+    initAxis(originY, dirY, y, stepY, tDeltaY, tMaxY);
+    initAxis(originZ, dirZ, z, stepZ, tDeltaZ, tMaxZ);
+
+    // the chunk the ray is in, looked up again only when it crosses a border
+    int chunkX = worldToChunk(x);
+    int chunkZ = worldToChunk(z);
+    const ChunkBlocks *blocks = lookup(chunkX, chunkZ);
+
+    int normalX = 0, normalY = 0, normalZ = 0;
+    float distance = 0.0f;
+
+    while (true)
+    {
+        if (!blocks)
+            return false;
+
+        if (y >= 0 && y < CHUNK_HEIGHT)
+        {
+            int block = (*blocks)[x - chunkX * CHUNK_WIDTH][y][z - chunkZ * CHUNK_WIDTH];
+            if (isSolidBlock(block))
+            {
+                hit.x = x;
+                hit.y = y;
+                hit.z = z;
+                hit.type = blockType(block);
+                hit.normalX = normalX;
+                hit.normalY = normalY;
+                hit.normalZ = normalZ;
+                hit.distance = distance;
+                return true;
+            }
+        }
+        else if ((y < 0 && stepY <= 0) || (y >= CHUNK_HEIGHT && stepY >= 0))
+        {
+            // above or below the world and not coming back
+            return false;
+        }
+
+        // step into the next block along the axis whose border is nearest
+        if (tMaxX < tMaxY && tMaxX < tMaxZ)
+        {
+            distance = tMaxX;
+            tMaxX += tDeltaX;
+            x += stepX;
+            normalX = -stepX;
+            normalY = normalZ = 0;
+        }
+        else if (tMaxY < tMaxZ)
+        {
+            distance = tMaxY;
+            tMaxY += tDeltaY;
+            y += stepY;
+            normalY = -stepY;
+            normalX = normalZ = 0;
+        }
+        else
+        {
+            distance = tMaxZ;
+            tMaxZ += tDeltaZ;
+            z += stepZ;
+            normalZ = -stepZ;
+            normalX = normalY = 0;
+        }
+
+        if (distance > maxDistance)
+            return false;
+
+        int newChunkX = worldToChunk(x);
+        int newChunkZ = worldToChunk(z);
+        if (newChunkX != chunkX || newChunkZ != chunkZ)
+        {
+            chunkX = newChunkX;
+            chunkZ = newChunkZ;
+            blocks = lookup(chunkX, chunkZ);
+        }
+    }
+}
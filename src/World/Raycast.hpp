@@ -0,0 +1,29 @@
+#pragma once
+#include <functional>
+#include "World/Block.hpp"
+
+struct RaycastHit
+{
+    // the block hit, world coordinates
+    int x, y, z;
+    int type;
+
+    // face the ray entered through (place a block at hit + normal), all 0
+    // if the ray started inside the block
+    int normalX, normalY, normalZ;
+
+    // along the ray from its origin, in blocks
+    float distance;
+};
+
+// blocks of a loaded chunk, or null. called once per chunk the ray enters,
+// not per block
+typedef std::function<const ChunkBlocks *(int chunkX, int chunkZ)> ChunkLookup;
+
+// Amanatides & Woo voxel traversal: visits exactly the blocks the ray
+// passes through, in order, until the first solid one (see isSolidBlock,
+// water is passed through). the direction doesnt need to be normalized.
+// stops (false) at maxDistance, at an unloaded chunk or once the ray left
+// the world vertically
+bool raycastBlocks(const ChunkLookup &lookup, float originX, float originY, float originZ,
+                   float dirX, float dirY, float dirZ, float maxDistance, RaycastHit &hit);
@@ -0,0 +1,219 @@
+#include "World/WorldGenerator.hpp"
+
+#include <cstdlib>
+
+#define STB_PERLIN_IMPLEMENTATION
+#include "STB/stb_perlin.h"
+
+WorldGenerator::WorldGenerator(const WorldGenParams &params) : params(params)
+{
+    // noise wraps every 256 on each axis, so the z slice picks another 8 bits of seed
+    noiseZ = (float)((params.seed >> 8) & 255);
+}
+
+int WorldGenerator::genRandomInt(int x, int z, int maxInt) const
+{
+    // randomize the seed with prime multiplication and bit manipulation
+    // (multiplied unsigned so overflow wraps instead of being undefined)
+    int seed = (int)((unsigned)x * 374761393u + (unsigned)z * 668265263u + (unsigned)params.seed * 1442695041u);
+    seed = (int)((unsigned)(seed ^ (seed >> 13)) * 1274126177u);
+    seed = seed ^ (seed >> 16);
+
+    // return the range (0 to maxInt)
+    return abs(seed % maxInt + 1);
+}
+
+int WorldGenerator::getTerrainY(int x, int z) const
+{
+    // generate noise
+    float noise = stb_perlin_noise3_seed(x * params.noiseScale, z * params.noiseScale, noiseZ, 0, 0, 0, params.seed); // -1 -> +1
+
+    float normalized = (noise + 1) / 2.0f;             // 0 -> 1
+    int height = (int)(normalized * params.maxHeight); // 0 -> maxHeight
+
+    return height + (CHUNK_HEIGHT - params.maxHeight);
+}
+
+void WorldGenerator::generateColumn(int x, int z, int column[CHUNK_HEIGHT]) const
+{
+    int terrainY = getTerrainY(x, z);
+
+    for (int y = 0; y < CHUNK_HEIGHT; y++)
+    {
+        // top layer (y = terrainY) is grass
+        if (y == terrainY)
+        {
+            column[y] = GRASS;
+        }
+        // then dirt
+        else if (y < terrainY && y >= terrainY - 3)
+        {
+            column[y] = DIRT;
+        }
+        else if (y < terrainY - 3 && y > 0)
+        {
+            column[y] = STONE;
+        }
+        else if (y == 0)
+        {
+            column[y] = BEDROCK;
+        }
+        else
+        {
+            column[y] = AIR;
+        }
+    }
+}
+
+// tree seed at world column x,z. returns false if there is no tree there
+bool WorldGenerator::getTreeSeed(int x, int z, int &y, int &trunkHeight) const
+{
+    // generate random int based on x,z
+    int randomInt = genRandomInt(x, z, 1000); // return integer between 0 - 1000
+    if (randomInt >= params.treeChance)
+        return false;
+
+    y = getTerrainY(x, z);
+    trunkHeight = genRandomInt(x, z, 3) + 4;
+
+    // the whole tree (leaves at y + trunkHeight) has to fit under the chunk top,
+    // otherwise the trunk gets cut off
+    return y + trunkHeight < CHUNK_HEIGHT;
+}
+
+// writes a structure block given in world x,z. blocks outside the chunk
+// are skipped, the neighbor chunk stamps them from the same seed
+void WorldGenerator::setStructureBlock(ChunkBlocks &blocks, int initialX, int initialZ, int x, int y, int z, int type, bool onlyIntoAir) const
+{
+    int localX = x - initialX;
+    int localZ = z - initialZ;
+
+    if (localX < 0 || localX >= CHUNK_WIDTH || localZ < 0 || localZ >= CHUNK_WIDTH || y < 0 || y >= CHUNK_HEIGHT)
+        return;
+    if (onlyIntoAir && blocks[localX][y][localZ] != AIR)
+        return;
+
+    blocks[localX][y][localZ] = type;
+}
+
+void WorldGenerator::genLeaves(ChunkBlocks &blocks, int initialX, int initialZ, int x, int y, int z) const
+{
+    for (int leafX = (x - TREE_LEAF_RADIUS); leafX <= (x + TREE_LEAF_RADIUS); leafX++)
+    {
+        setStructureBlock(blocks, initialX, initialZ, leafX, y, z, LEAVES, true);
+    }
+}
+
+void WorldGenerator::genTree(ChunkBlocks &blocks, int initialX, int initialZ, int x, int y, int z, int trunkHeight) const
+{
+    // make a tree at x, y, z (trunk replaces the grass block)
+    for (int treeY = 0; treeY < trunkHeight; treeY++)
+    {
+        setStructureBlock(blocks, initialX, initialZ, x, y + treeY, z, LOG, false);
+    }
+}
+
+// structure pass: every tree whose seed is within STRUCTURE_MARGIN of the
+// chunk gets stamped, so trees crossing the border come out the same in
+// both chunks without waiting for (or locking) the neighbor
+void WorldGenerator::genFeatures(ChunkBlocks &blocks, int initialX, int initialZ) const
+{
+    int fromX = initialX - STRUCTURE_MARGIN;
+    int fromZ = initialZ - STRUCTURE_MARGIN;
+    int toX = initialX + CHUNK_WIDTH - 1 + STRUCTURE_MARGIN;
+    int toZ = initialZ + CHUNK_WIDTH - 1 + STRUCTURE_MARGIN;
+
+    // leaves first and only into air, then trunks over everything, so the
+    // result doesnt depend on which tree of the margin gets stamped first
+    for (int x = fromX; x <= toX; x++)
+    {
+        for (int z = fromZ; z <= toZ; z++)
+        {
+            int y, trunkHeight;
+            if (getTreeSeed(x, z, y, trunkHeight))
+                genLeaves(blocks, initialX, initialZ, x, y + trunkHeight, z);
+        }
+    }
+
+    for (int x = fromX; x <= toX; x++)
+    {
+        for (int z = fromZ; z <= toZ; z++)
+        {
+            int y, trunkHeight;
+            if (getTreeSeed(x, z, y, trunkHeight))
+                genTree(blocks, initialX, initialZ, x, y, z, trunkHeight);
+        }
+    }
+}
+
+void WorldGenerator::generateChunk(int chunkX, int chunkZ, ChunkBlocks &blocks) const
+{
+    // generate form (16x, 16z) to (16x + 15, 16z + 15)
+    int initialX = chunkX * CHUNK_WIDTH;
+    int initialZ = chunkZ * CHUNK_WIDTH;
+
+    for (int localX = 0; localX < CHUNK_WIDTH; localX++)
+    {
+        for (int localZ = 0; localZ < CHUNK_WIDTH; localZ++)
+        {
+            int column[CHUNK_HEIGHT];
+            generateColumn(initialX + localX, initialZ + localZ, column);
+
+            for (int y = 0; y < CHUNK_HEIGHT; y++)
+            {
+                blocks[localX][y][localZ] = column[y];
+            }
+        }
+    }
+
+    // NOTE: calling it after terrrain generation because terrain generation will set rest of the blocks to air
+    genFeatures(blocks, initialX, initialZ);
+}
+
+void WorldGenerator::generateHeightmap(int chunkX, int chunkZ, ChunkHeightmap &map) const
+{
+    int initialX = chunkX * CHUNK_WIDTH;
+    int initialZ = chunkZ * CHUNK_WIDTH;
+
+    for (int localX = 0; localX < CHUNK_WIDTH; localX++)
+    {
+        for (int localZ = 0; localZ < CHUNK_WIDTH; localZ++)
+        {
+            map.height[localX][localZ] = getTerrainY(initialX + localX, initialZ + localZ);
+            map.top[localX][localZ] = GRASS;
+        }
+    }
+
+    // the trees of genFeatures, only their highest blocks: a leaf counts
+    // where it is above everything else (it only goes into air), a trunk
+    // top also where it is level with one (trunks go over leaves)
+    for (int x = initialX - STRUCTURE_MARGIN; x <= initialX + CHUNK_WIDTH - 1 + STRUCTURE_MARGIN; x++)
+    {
+        for (int z = initialZ - STRUCTURE_MARGIN; z <= initialZ + CHUNK_WIDTH - 1 + STRUCTURE_MARGIN; z++)
+        {
+            int y, trunkHeight;
+            if (!getTreeSeed(x, z, y, trunkHeight))
+                continue;
+
+            int localZ = z - initialZ;
+            if (localZ < 0 || localZ >= CHUNK_WIDTH)
+                continue;
+            for (int leafX = x - TREE_LEAF_RADIUS; leafX <= x + TREE_LEAF_RADIUS; leafX++)
+            {
+                int localX = leafX - initialX;
+                if (localX >= 0 && localX < CHUNK_WIDTH && y + trunkHeight > map.height[localX][localZ])
+                {
+                    map.height[localX][localZ] = y + trunkHeight;
+                    map.top[localX][localZ] = LEAVES;
+                }
+            }
+
+            int localX = x - initialX;
+            if (localX >= 0 && localX < CHUNK_WIDTH && y + trunkHeight - 1 >= map.height[localX][localZ])
+            {
+                map.height[localX][localZ] = y + trunkHeight - 1;
+                map.top[localX][localZ] = LOG;
+            }
+        }
+    }
+}
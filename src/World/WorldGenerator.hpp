@@ -0,0 +1,53 @@
+#pragma once
+#include "World/Block.hpp"
+
+// trees: leaves reach TREE_LEAF_RADIUS blocks out of the trunk column, so a
+// chunk has to look at tree seeds that far outside its own border
+const int TREE_LEAF_RADIUS = 2;
+const int STRUCTURE_MARGIN = TREE_LEAF_RADIUS;
+
+// everything the generator reads. two generators made from equal params
+// produce the exact same world
+struct WorldGenParams
+{
+    int seed = 0;
+    float noiseScale = 0.05f;
+    int maxHeight = 20;
+    int treeChance = 6; // trees per 1000 columns
+};
+
+// seed + params -> block data for a chunk coordinate.
+// no GL and no global state, every method is const so one generator can be
+// shared by any number of worker threads (or used from tools / a server)
+class WorldGenerator
+{
+public:
+    explicit WorldGenerator(const WorldGenParams &params);
+
+    const WorldGenParams &getParams() const { return params; }
+
+    // terrain surface (grass block) y of a world column
+    int getTerrainY(int x, int z) const;
+
+    // terrain of one world column without structures, column[y] for y in 0..CHUNK_HEIGHT-1
+    void generateColumn(int x, int z, int column[CHUNK_HEIGHT]) const;
+
+    // full chunk at chunk coordinate (chunkX, chunkZ) = world (16 * chunkX, 16 * chunkZ)
+    void generateChunk(int chunkX, int chunkZ, ChunkBlocks &blocks) const;
+
+    // only the surface generateChunk would make, straight from the noise and
+    // the tree seeds without filling any blocks. for far LOD tiles
+    void generateHeightmap(int chunkX, int chunkZ, ChunkHeightmap &map) const;
+
+private:
+    WorldGenParams params;
+    float noiseZ; // upper seed bits, stb_perlin only takes 8 bits of seed
+
+    int genRandomInt(int x, int z, int maxInt) const;
+    bool getTreeSeed(int x, int z, int &y, int &trunkHeight) const;
+
+    void setStructureBlock(ChunkBlocks &blocks, int initialX, int initialZ, int x, int y, int z, int type, bool onlyIntoAir) const;
+    void genLeaves(ChunkBlocks &blocks, int initialX, int initialZ, int x, int y, int z) const;
+    void genTree(ChunkBlocks &blocks, int initialX, int initialZ, int x, int y, int z, int trunkHeight) const;
+    void genFeatures(ChunkBlocks &blocks, int initialX, int initialZ) const;
+};
@@ -1,7 +1,9 @@
 #include "main.hpp"
 
 // basic stuff
+#include <algorithm>
 #include <map>
+#include <memory>
 #include <vector>
 
 // multithreading
@@ -12,6 +14,10 @@
 // this code runs background musics
 bool playBgm()
 {
+#ifndef MINECRAFT_AUDIO
+    // built without SDL2_mixer
+    return false;
+#else
     std::cout << "playBgm called" << std::endl;
 
     if (SDL_Init(SDL_INIT_AUDIO) < 0)
@@ -40,32 +46,69 @@ bool playBgm()
     // Start the music (loop forever)
     Mix_PlayMusic(bgm, -1);
     return true;
+#endif
 }
 
-// blocktypes
-enum BlockType
-{
-    AIR,     // 0
-    GRASS,   // 1
-    DIRT,    // 2
-    STONE,   // 3
-    BEDROCK, // 4
-    LOG,     // 5
-    LEAVES,  // 6
-};
-
 // shader class
 Shader *shader;
 
 // some variables
-// Chunk size
-const int CHUNK_WIDTH = 16;
-const int CHUNK_HEIGHT = 32; // 16 until we add caves via 3D noise
 int renderDistance = 5;
 
-float noise_scale = 0.05f;
 static std::mutex coutMutex;
-int maxHeight = 20;
+
+// world generation: the debug sliders edit worldParams, chunks only ever read
+// the immutable generator snapshot they were created with
+WorldGenParams worldParams;
+std::shared_ptr<const WorldGenerator> worldGenerator;
+
+// saved chunks of the current world, see worldDirectory
+std::shared_ptr<RegionStore> regionStore;
+
+// every set of generator params is its own world on disk, so changing the
+// sliders and reloading never mixes chunks of two different terrains
+std::string worldDirectory(const WorldGenParams &params)
+{
+    char name[128];
+    snprintf(name, sizeof(name), "worlds/seed%d_scale%d_height%d_trees%d/region",
+             params.seed, (int)(params.noiseScale * 1000.0f + 0.5f), params.maxHeight, params.treeChance);
+    return name;
+}
+
+// chunk generation / meshing workers, created in initialization
+ThreadPool *chunkWorkers = nullptr;
+
+// writes edited chunks in the background, outlives the chunks and workers
+ChunkSaver *chunkSaver = nullptr;
+
+// attributes of the chunk vertex layout (see VERTEX_FLOATS) for the bound
+// VAO and VBO
+static void setChunkVertexLayout()
+{
+    // position
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void *)0);
+
+    // uv
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void *)(3 * sizeof(float)));
+
+    // face
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void *)(5 * sizeof(float)));
+
+    // blocktype
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void *)(6 * sizeof(float)));
+
+    // light
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void *)(7 * sizeof(float)));
+
+    // ambient occlusion
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void *)(8 * sizeof(float)));
+}
 
 // Chunk Class
 // this si the core code, it generates the chunk and shows in the screen
@@ -73,328 +116,796 @@ class Chunk {
 private:
     int initialX;
     int initialZ;
-    int finalX;
-    int finalZ;
 
-    // all the blocks generated int eh chunk are stored in this 3d array
-    int blocks[CHUNK_WIDTH][CHUNK_HEIGHT][CHUNK_WIDTH];
+    // blocks + vertices, shared with the worker job building them
+    std::shared_ptr<ChunkData> data;
+    std::shared_ptr<RegionStore> store;
 
-    std::atomic<bool> verticesLoaded{false};
-    bool verticesUploaded = false;
+    // one buffer per vertical section, so an edit re-uploads only those.
+    // the layers of a section are consecutive ranges of its buffer
+    int vertexCount[SECTION_COUNT] = {};
+    int layerFirst[SECTION_COUNT][LAYER_COUNT] = {};
+    int layerCount[SECTION_COUNT][LAYER_COUNT] = {};
+    unsigned int VAO[SECTION_COUNT], VBO[SECTION_COUNT];
+    bool hasBuffers = false;
 
-    std::vector<float> vertices; // use array[CHUNKWIDTH*CHUNKWIDTH*CHUNKHEIGHT*36] for better memory management
+    // render thread time of the oldest edit not visible yet, 0 if none
+    uint64_t editMicros = 0;
 
-    unsigned int VAO, VBO;
+    // of the uploaded meshes, for the culling (cullChunks)
+    uint8_t occluderHeights[SECTION_COUNT][OCCLUDER_CELLS][OCCLUDER_CELLS] = {};
+    uint8_t faceConnections[SECTION_COUNT][6] = {};
+    bool sectionVisible[SECTION_COUNT] = {};
 
 
-    enum FaceDirection
+    // uploads data->meshes[section], replacing whatever mesh the section
+    // had. the draw after this uses the new mesh whole, never a mix of both
+    void setVertices(int section)
     {
-        TOP,
-        BOTTOM,
-        FRONT,
-        BACK,
-        LEFT,
-        RIGHT,
-    };
-
-    void setVertices()
-    {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
+        SectionMesh &mesh = data->meshes[section];
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-        // buffer data
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        if (!hasBuffers)
+        {
+            glGenVertexArrays(SECTION_COUNT, VAO);
+            glGenBuffers(SECTION_COUNT, VBO);
 
-        // vao attibutes
+            for (int i = 0; i < SECTION_COUNT; i++)
+            {
+                glBindVertexArray(VAO[i]);
+                glBindBuffer(GL_ARRAY_BUFFER, VBO[i]);
+                setChunkVertexLayout();
+            }
 
-        // position
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void *)0);
+            glBindVertexArray(0);
+            hasBuffers = true;
+        }
 
-        // uv
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void *)(3 * sizeof(float)));
+        // buffer data, a fresh store so the driver can orphan the old one,
+        // then the layers one after the other
+        size_t floats = mesh.floatCount();
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[section]);
+        glBufferData(GL_ARRAY_BUFFER, floats * sizeof(float), nullptr, GL_STATIC_DRAW);
+        size_t offset = 0;
+        for (int layer = 0; layer < LAYER_COUNT; layer++)
+        {
+            const std::vector<float> &vertices = mesh.layers[layer];
+            if (!vertices.empty())
+                glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(float), vertices.size() * sizeof(float), vertices.data());
+            layerFirst[section][layer] = offset / VERTEX_FLOATS;
+            layerCount[section][layer] = vertices.size() / VERTEX_FLOATS;
+            offset += vertices.size();
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        // face
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void *)(5 * sizeof(float)));
+        Metrics::add(METRIC_GPU_VERTEX_BYTES, ((int64_t)floats - (int64_t)vertexCount[section] * VERTEX_FLOATS) * (int64_t)sizeof(float));
+        vertexCount[section] = floats / VERTEX_FLOATS;
 
-        // blocktype
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void *)(6 * sizeof(float)));
+        memcpy(occluderHeights[section], mesh.occluderHeights, sizeof(occluderHeights[section]));
+        memcpy(faceConnections[section], mesh.faceConnections, sizeof(faceConnections[section]));
 
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // the GPU has its own copy now
+        mesh = SectionMesh();
+        data->updateVertexBytes();
     }
 
-    int genRandomInt(int x, int z, int maxInt)
+    void sectionBox(int section, float min[3], float max[3]) const
     {
-        // randomize the seed with prime multiplication and bit manipulation
-        int seed = x * 374761393 + z * 668265263;
-        seed = (seed ^ (seed >> 13)) * 1274126177;
-        seed = seed ^ (seed >> 16);
-
-        // return the range (0 to maxInt(100))
-        return abs(seed % maxInt + 1);
+        min[0] = (float)initialX;
+        min[1] = (float)(section * SECTION_HEIGHT);
+        min[2] = (float)initialZ;
+        max[0] = min[0] + CHUNK_WIDTH;
+        max[1] = min[1] + SECTION_HEIGHT;
+        max[2] = min[2] + CHUNK_WIDTH;
     }
 
-    void genLeaves(int x, int y, int z)
+    // runs on a chunk worker. only touches ChunkData, the generator snapshot
+    // and the region store, so the worker never reads the slider globals
+    static void buildVertices(std::shared_ptr<ChunkData> data, std::shared_ptr<const WorldGenerator> generator, std::shared_ptr<RegionStore> store)
     {
-        if (y >= CHUNK_HEIGHT) return;
-
-        for (int leafX = (x - 2); leafX <= (x + 2); leafX++) {
-            if (leafX < 0 || leafX >= CHUNK_WIDTH) continue;
-            blocks[leafX][y][z] = LEAVES;
+        if (data->cancelled)
+        {
+            // unloaded before we got to it
+            Metrics::increment(METRIC_CHUNKS_CANCELLED);
+            return;
+        }
+        data->setState(CHUNK_GENERATING);
 
-            // std::lock_guard<std::mutex> lock(coutMutex);
-            // std::cout << "Set leaf at: " << leafX << ", " << y << ", " << z << ", x: " << x << std::endl;
-            // std::cout << "existance in blocks: " << (blocks[leafX][y][z] ? "true" : "false") << std::endl;
+        // an edited copy still waiting for the saver wins over the disk,
+        // saved chunks are cheaper to load than to generate
+        if (chunkSaver->reclaim(*data, store))
+        {
+            chunkSaver->markDirty(data, store);
         }
-    }
+        else if (!store->loadChunk(data->chunkX, data->chunkZ, data->blocks))
+        {
+            {
+                PROFILE_SCOPE("genChunk");
+                generator->generateChunk(data->chunkX, data->chunkZ, data->blocks); // set blocks
+            }
+            Metrics::increment(METRIC_CHUNKS_GENERATED);
+            store->saveChunkAsync(data->chunkX, data->chunkZ, data->blocks);
+        }
+        {
+            PROFILE_SCOPE("lightChunk");
+            computeChunkLight(data->blocks, data->light);
+            countRandomTicked(data->blocks, data->randomTicked);
+        }
+        {
+            PROFILE_SCOPE("buildMesh");
+            for (int section = 0; section < SECTION_COUNT; section++)
+                buildSectionMesh(data->blocks, data->light, section, data->chunkX * CHUNK_WIDTH, data->chunkZ * CHUNK_WIDTH, data->meshes[section]); // build vertices array from blocks
+        }
+        data->updateVertexBytes();
 
+        data->setState(CHUNK_MESHED);
+    }
 
-    void genTree(int x, int y, int z)
+    // runs on a chunk worker after an edit. meshes the dirty sections of a
+    // copy of the blocks, so the render thread only waits for the copy when
+    // it edits meanwhile
+    static void remesh(std::shared_ptr<ChunkData> data)
     {
-        // make a tree at x,  + 1, z
+        PROFILE_SCOPE("remesh");
+        if (data->cancelled)
+            return;
 
-        int trunkHeight = genRandomInt(x, z, 3) + 4;
+        // edits from here on queue another remesh
+        unsigned int sections = data->dirtySections.exchange(0);
 
-        int localX = x - initialX;
-        int localZ = z - initialZ;
+        struct BlockBuffer
+        {
+            ChunkBlocks blocks;
+            ChunkLight light;
+        };
+        std::unique_ptr<BlockBuffer> copy(new BlockBuffer());
+        uint32_t version;
+        {
+            std::lock_guard<std::mutex> lock(data->blocksMutex);
+            version = data->getVersion();
+            memcpy(copy->blocks, data->blocks, sizeof(ChunkBlocks));
+            memcpy(copy->light, data->light, sizeof(ChunkLight));
+        }
 
-        for (int treeY = 0; treeY <= trunkHeight; treeY++)
+        for (int section = 0; section < SECTION_COUNT; section++)
         {
-            int targetY = y + treeY;
+            if (!(sections & (1u << section)))
+                continue;
+            SectionMesh mesh;
+            buildSectionMesh(copy->blocks, copy->light, section, data->chunkX * CHUNK_WIDTH, data->chunkZ * CHUNK_WIDTH, mesh);
+            data->publishMesh(section, std::move(mesh), version);
+        }
+    }
 
-            if (targetY < CHUNK_HEIGHT)
-            {
-                blocks[localX][targetY][localZ] = LOG;
-            }
+public:
+    void uploadToGpu()
+    {
+        if (data->getState() == CHUNK_MESHED)
+        {
+            for (int section = 0; section < SECTION_COUNT; section++)
+                setVertices(section);
+            data->setState(CHUNK_UPLOADED);
+        }
 
-            if (treeY == trunkHeight)
+        // remeshed sections finished, swap them in
+        if (data->getState() != CHUNK_UPLOADED)
+            return;
+        bool swapped = false;
+        for (int section = 0; section < SECTION_COUNT; section++)
+        {
+            if (data->takeMesh(section, data->meshes[section]))
             {
-                // gen leaves at x,y,z
-                genLeaves(localX, targetY, localZ);
+                setVertices(section);
+                swapped = true;
             }
         }
+        if (swapped && editMicros != 0 && data->dirtySections == 0)
+        {
+            Metrics::set(METRIC_EDIT_LATENCY_US, (int64_t)(Profiler::nowMicros() - editMicros));
+            editMicros = 0;
+        }
     }
 
-    void genFeatures(int x, int z, int y)
+    ~Chunk()
     {
-        // generate random int based on x,z
-        int randomInt = genRandomInt(x, z, 1000); // return integer between 0 - 100
+        data->cancelled = true;
+
+        // edits not on disk yet go to the saver, the blocks live on there
+        chunkSaver->saveOnUnload(data, store);
 
-        if (randomInt < 6)
+        if (hasBuffers)
         {
-            // generate tree 1% chance
-            genTree(x, y, z);
+            glDeleteBuffers(SECTION_COUNT, VBO);
+            glDeleteVertexArrays(SECTION_COUNT, VAO);
+            for (int section = 0; section < SECTION_COUNT; section++)
+                Metrics::add(METRIC_GPU_VERTEX_BYTES, -(int64_t)vertexCount[section] * VERTEX_FLOATS * sizeof(float));
         }
+        Metrics::increment(METRIC_CHUNKS_UNLOADED);
+    }
+
+    Chunk(int x, int z, std::shared_ptr<const WorldGenerator> generator, std::shared_ptr<RegionStore> store)
+    {
+        // generate form (16x, 16z) to (16x + 15, 16z + 15)
+        initialX = x * 16;
+        initialZ = z * 16;
+
+        data = std::make_shared<ChunkData>(x, z);
+        this->store = store;
+        chunkWorkers->enqueue(std::bind(&Chunk::buildVertices, data, std::move(generator), std::move(store)));
     }
 
-    void genChunk()
+    // false until the worker is done with the blocks
+    bool isEditable() const { return data->getState() >= CHUNK_MESHED; }
+
+    bool isUploaded() const { return data->getState() == CHUNK_UPLOADED; }
+
+    // same rule as getBlocks
+    int getBlock(int localX, int y, int localZ) const { return data->blocks[localX][y][localZ]; }
+
+    // bit per section with random ticked blocks, same lock as writeBlock
+    unsigned int getRandomTickedSections() const
     {
-        for (int x = initialX; x <= finalX; x++)
+        unsigned int sections = 0;
+        for (int section = 0; section < SECTION_COUNT; section++)
         {
-            float nx = x * noise_scale;
-            for (int z = initialZ; z <= finalZ; z++)
-            {
-                float nz = z * noise_scale;
+            if (data->randomTicked[section] > 0)
+                sections |= 1u << section;
+        }
+        return sections;
+    }
 
-                // generate noise
-                float noise = stb_perlin_noise3(nx, nz, 0.0f, 0, 0, 0); // -1 -> +1
+    // once the chunk is editable every write goes through writeBlock, from
+    // the render thread (edits), the simulation thread (scheduled ticks) and
+    // the random tick workers, always holding worldMutex and blocksMutex.
+    // so read here under worldMutex (picking, physics, the tick rules; a
+    // random tick worker only reads chunks no other worker writes), or
+    // copy under blocksMutex from anywhere else (copyBlocks)
+    const ChunkBlocks &getBlocks() const { return data->blocks; }
 
-                float normalized = (noise + 1) / 2.0f;      // 0 -> 1
-                int height = (int)(normalized * maxHeight); // 0 -> maxHeight(10)
+    // a consistent copy without worldMutex, same lock as writeBlock
+    void copyBlocks(ChunkBlocks &out) const
+    {
+        std::lock_guard<std::mutex> lock(data->blocksMutex);
+        memcpy(out, data->blocks, sizeof(ChunkBlocks));
+    }
 
-                int localX = x - initialX;
-                int localZ = z - initialZ;
+    // the block and its light change now, returns the sections to remesh.
+    // under worldMutex, see getBlocks
+    unsigned int writeBlock(int localX, int y, int localZ, int block)
+    {
+        unsigned int lightSections;
+        {
+            std::lock_guard<std::mutex> lock(data->blocksMutex);
+            int &slot = data->blocks[localX][y][localZ];
+            data->randomTicked[y / SECTION_HEIGHT] += (int)isRandomTicked(block) - (int)isRandomTicked(slot);
+            slot = block;
+            lightSections = updateLightAfterEdit(data->blocks, data->light, localX, y, localZ);
+            data->markEdited();
+        }
+        chunkSaver->markDirty(data, store);
+        return sectionsTouchedBy(y) | lightSections;
+    }
 
-                int terrainY = height + (CHUNK_HEIGHT - maxHeight);
+    // render thread only. the sections the edit touches follow a frame or
+    // so later once a worker rebuilt them
+    void setBlock(int localX, int y, int localZ, int type)
+    {
+        unsigned int sections = writeBlock(localX, y, localZ, type);
+        if (editMicros == 0)
+            editMicros = Profiler::nowMicros();
+        requestRemesh(sections);
+    }
 
-                for (int y = 0; y < CHUNK_HEIGHT; y++)
-                {
+    void requestRemesh(unsigned int sections)
+    {
+        if (!isEditable() || data->dirtySections.fetch_or(sections) != 0)
+            return;
+        chunkWorkers->enqueueUrgent(std::bind(&Chunk::remesh, data));
+    }
 
-                    // top layer (y = terrainY) is grass
-                    if (y == terrainY)
-                    {
-                        blocks[localX][y][localZ] = GRASS;
-                    }
-                    // then dirt
-                    else if (y < terrainY && y >= terrainY - 3)
-                    {
-                        blocks[localX][y][localZ] = DIRT;
-                    }
-                    else if (y < terrainY - 3 && y > 0)
-                    {
-                        blocks[localX][y][localZ] = STONE;
-                    }
-                    else if (y == 0)
-                    {
-                        blocks[localX][y][localZ] = BEDROCK;
-                    }
-                    else
-                    {
-                        blocks[localX][y][localZ] = AIR;
-                    }
-                }
+    bool hasLayer(int section, RenderLayer layer) const
+    {
+        return data->getState() == CHUNK_UPLOADED && layerCount[section][layer] > 0;
+    }
+
+    // the solid columns of the chunk hide what is behind them
+    void addOccluders(OcclusionCuller &culler) const
+    {
+        if (!isUploaded())
+            return;
+        int heights[OCCLUDER_CELLS * OCCLUDER_CELLS];
+        chunkOccluderHeights(occluderHeights, heights);
+        culler.addOccluderHeightfield((float)initialX, (float)initialZ, (float)OCCLUDER_CELL, OCCLUDER_CELLS, heights);
+    }
+
+    // nullptr until uploaded, the section graph walks through those
+    const uint8_t *getFaceConnections(int section) const { return isUploaded() ? faceConnections[section] : nullptr; }
 
-                // NOTE: calling it after terrrain generation because terrain generation will set rest of the blocks to air
-                genFeatures(x, z, terrainY);
+    // decides which sections drawSection draws this frame, returns how
+    // many of them the graph (if any) left out
+    int cull(OcclusionCuller &culler, const SectionGraph *graph)
+    {
+        int graphCulled = 0;
+        for (int section = 0; section < SECTION_COUNT; section++)
+        {
+            sectionVisible[section] = false;
+            if (!isUploaded() || vertexCount[section] == 0)
+                continue;
+            if (graph && !graph->isReachable(data->chunkX, section, data->chunkZ))
+            {
+                graphCulled++;
+                continue;
             }
+            float min[3], max[3];
+            sectionBox(section, min, max);
+            sectionVisible[section] = culler.isVisible(min, max);
         }
+        return graphCulled;
+    }
+
+    void drawSection(int section, RenderLayer layer)
+    {
+        if (!hasLayer(section, layer) || !sectionVisible[section])
+            return;
+        glBindVertexArray(VAO[section]);
+        glDrawArrays(GL_TRIANGLES, layerFirst[section][layer], layerCount[section][layer]);
     }
 
-    bool isAir(int x, int y, int z)
+    // world space distance from a point to the middle of a section
+    float sectionDistance(int section, const glm::vec3 &point) const
+    {
+        glm::vec3 center(initialX + CHUNK_WIDTH * 0.5f, (section + 0.5f) * SECTION_HEIGHT, initialZ + CHUNK_WIDTH * 0.5f);
+        return glm::distance(center, point);
+    }
+};
+
+std::map<std::pair<int, int>, std::unique_ptr<Chunk>> chunks;
+
+// distant chunks, out to lodDistance, are only a coarse mesh of 2, 4 or 8
+// blocks per cell. nothing else of them is kept, they cant be edited,
+// ticked or walked on
+int lodDistance = 16;
+
+// tiles this coarse are heightfields of the surface alone (generateHeightmap,
+// buildHeightfieldMesh), finer ones downsampled blocks (buildLodMesh). a
+// tile turns into the next finer one, then the full chunk, as the player
+// gets closer
+const int LOD_HEIGHTFIELD_SCALE = 4;
+
+// a separate worker for them, so the full chunks near the player never
+// wait behind a far ring
+ThreadPool *lodWorkers = nullptr;
+
+// blocks per LOD cell at a chebyshev chunk distance past renderDistance,
+// doubling every renderDistance chunks
+int lodScaleAt(int distance)
+{
+    int ring = (distance - 1) / std::max(renderDistance, 1);
+    return ring <= 1 ? 2 : ring <= 3 ? 4 : 8;
+}
+
+class LodChunk
+{
+private:
+    // what the worker fills in, the render thread uploads it once ready
+    struct Job
+    {
+        int chunkX, chunkZ, scale;
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> ready{false};
+        SectionMesh mesh;
+    };
+    std::shared_ptr<Job> job;
+
+    int layerFirst[LAYER_COUNT] = {};
+    int layerCount[LAYER_COUNT] = {};
+    int vertexCount = 0;
+    unsigned int VAO = 0, VBO = 0;
+    bool uploaded = false;
+
+    // highest vertex, the tile's box for the culling, and what it decided
+    float top = 0.0f;
+    bool visible = true;
+
+    // the tile this one replaces, drawn until this one is uploaded
+    std::unique_ptr<LodChunk> previous;
+
+    // runs on the LOD worker. the saved chunk if there is one (edits show
+    // once saved), else the generator's, never written back. heightfield
+    // tiles of unsaved chunks never fill any blocks
+    static void build(std::shared_ptr<Job> job, std::shared_ptr<const WorldGenerator> generator, std::shared_ptr<RegionStore> store)
     {
-        // first cheack if x,y,z is valid
-        if (x < 0 || x >= CHUNK_WIDTH || z < 0 || z >= CHUNK_WIDTH || y < 0 || y >= CHUNK_HEIGHT)
+        if (job->cancelled)
+            return;
+        PROFILE_SCOPE("lodChunk");
+
+        struct BlockBuffer
+        {
+            ChunkBlocks blocks;
+        };
+        std::unique_ptr<BlockBuffer> buffer(new BlockBuffer());
+        bool saved = store->loadChunk(job->chunkX, job->chunkZ, buffer->blocks);
+        int initialX = job->chunkX * CHUNK_WIDTH;
+        int initialZ = job->chunkZ * CHUNK_WIDTH;
+        if (job->scale >= LOD_HEIGHTFIELD_SCALE)
         {
-            return true;
+            ChunkHeightmap map;
+            if (saved)
+                computeHeightmap(buffer->blocks, map);
+            else
+                generator->generateHeightmap(job->chunkX, job->chunkZ, map);
+            buildHeightfieldMesh(map, job->scale, initialX, initialZ, job->mesh);
         }
-        // if the block inside chunk, cheack if its assigned as air or not
-        if (blocks[x][y][z] == AIR)
+        else
         {
-            return true;
+            if (!saved)
+                generator->generateChunk(job->chunkX, job->chunkZ, buffer->blocks);
+            buildLodMesh(buffer->blocks, job->scale, initialX, initialZ, job->mesh);
         }
+        job->ready.store(true, std::memory_order_release);
+    }
 
-        return false;
+public:
+    LodChunk(int x, int z, int scale, std::unique_ptr<LodChunk> previous)
+        : job(std::make_shared<Job>()), previous(std::move(previous))
+    {
+        job->chunkX = x;
+        job->chunkZ = z;
+        job->scale = scale;
+        lodWorkers->enqueue(std::bind(&LodChunk::build, job, worldGenerator, regionStore));
     }
 
-    // x, y, z, u, v, face, type
-    float localPos[6][6][3] = {
-        {{1.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 0.0f}}, // TOP
-        {{1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}, // BOTTOM
-        {{1.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}}, // FRONT
-        {{0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}}, // BACK
-        {{0.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 1.0f}}, // LEFT
-        {{1.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}}  // RIGHT
-    };
+    ~LodChunk()
+    {
+        job->cancelled = true;
+        if (uploaded)
+        {
+            glDeleteBuffers(1, &VBO);
+            glDeleteVertexArrays(1, &VAO);
+            Metrics::decrement(METRIC_LOD_CHUNKS);
+            Metrics::add(METRIC_LOD_GPU_VERTEX_BYTES, -(int64_t)vertexCount * VERTEX_FLOATS * sizeof(float));
+        }
+    }
 
-    // for vertex in each face
-    float localUv[6][2] = {
-        {1.0f, 1.0f},
-        {0.0f, 1.0f},
-        {0.0f, 0.0f},
-        {0.0f, 0.0f},
-        {1.0f, 0.0f},
-        {1.0f, 1.0f}
-    };
+    int getScale() const { return job->scale; }
 
-    void addFace(FaceDirection face, int x, int y, int z, int type)
+    void uploadToGpu()
     {
-        // Debug: Print when adding leaf faces
-        // if (type == LEAVES) {
-        //     std::lock_guard<std::mutex> lock(coutMutex);
-        //     std::cout << "Adding leaf face: " << x << ", " << y << ", " << z << ", face: " << face << std::endl;
-        // }
-        
-        // add vace vertex to verticies vector
-        for (int vertex = 0; vertex < 6; vertex++)
+        if (uploaded)
+            return;
+        if (!job->ready.load(std::memory_order_acquire))
         {
-            float* pos = localPos[face][vertex];
-            float* uv = localUv[vertex];
-
-            // Convert local coordinates to world coordinates
-            vertices.push_back(pos[0] + x + initialX);
-            vertices.push_back(pos[1] + y);
-            vertices.push_back(pos[2] + z + initialZ);
+            if (previous)
+                previous->uploadToGpu();
+            return;
+        }
 
-            vertices.push_back(uv[0]);
-            vertices.push_back(uv[1]);
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        setChunkVertexLayout();
 
-            vertices.push_back(static_cast<float>(face)); // for face of block texture
-            vertices.push_back(static_cast<float>(type)); // for block texture
+        SectionMesh &mesh = job->mesh;
+        glBufferData(GL_ARRAY_BUFFER, mesh.floatCount() * sizeof(float), nullptr, GL_STATIC_DRAW);
+        size_t offset = 0;
+        for (int layer = 0; layer < LAYER_COUNT; layer++)
+        {
+            const std::vector<float> &vertices = mesh.layers[layer];
+            if (!vertices.empty())
+                glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(float), vertices.size() * sizeof(float), vertices.data());
+            layerFirst[layer] = offset / VERTEX_FLOATS;
+            layerCount[layer] = vertices.size() / VERTEX_FLOATS;
+            offset += vertices.size();
+            for (size_t i = 1; i < vertices.size(); i += VERTEX_FLOATS)
+                top = std::max(top, vertices[i]);
         }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+
+        vertexCount = offset / VERTEX_FLOATS;
+        mesh = SectionMesh();
+        uploaded = true;
+        previous.reset();
+        Metrics::increment(METRIC_LOD_CHUNKS);
+        Metrics::add(METRIC_LOD_GPU_VERTEX_BYTES, (int64_t)vertexCount * VERTEX_FLOATS * sizeof(float));
     }
 
-    void buildMesh()
+    void cull(OcclusionCuller &culler)
     {
-        vertices.clear();
-
-        for (int x = 0; x < CHUNK_WIDTH; x++)
+        if (!uploaded)
         {
-            for (int y = 0; y < CHUNK_HEIGHT; y++)
-            {
-                for (int z = 0; z < CHUNK_WIDTH; z++)
-                {
-                    int type = blocks[x][y][z];
-                    if (type == AIR)
-                        continue;
-
-                    // add each exposed face if block is not air
-                    if (isAir(x, y + 1, z))
-                        addFace(TOP, x, y, z, type); // add top face
-                    if (isAir(x, y - 1, z))
-                        addFace(BOTTOM, x, y, z, type); // add bottom face
-                    if (isAir(x + 1, y, z))
-                        addFace(RIGHT, x, y, z, type); // add right face
-                    if (isAir(x - 1, y, z))
-                        addFace(LEFT, x, y, z, type); // add left face
-                    if (isAir(x, y, z + 1))
-                        addFace(FRONT, x, y, z, type); // add front face
-                    if (isAir(x, y, z - 1))
-                        addFace(BACK, x, y, z, type); // add back face
-                }
-            }
+            if (previous)
+                previous->cull(culler);
+            return;
         }
+        float min[3] = {(float)(job->chunkX * CHUNK_WIDTH), 0.0f, (float)(job->chunkZ * CHUNK_WIDTH)};
+        float max[3] = {min[0] + CHUNK_WIDTH, top, min[2] + CHUNK_WIDTH};
+        visible = vertexCount > 0 && culler.isVisible(min, max);
+    }
 
-        // print(logCount);
+    void draw(RenderLayer layer)
+    {
+        if (!uploaded)
+        {
+            if (previous)
+                previous->draw(layer);
+            return;
+        }
+        if (layerCount[layer] == 0 || !visible)
+            return;
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, layerFirst[layer], layerCount[layer]);
     }
+};
+
+std::map<std::pair<int, int>, std::unique_ptr<LodChunk>> lodChunks;
+
+// (re)creates the LOD tiles of the ring around the player, nearest first,
+// and drops the ones out of it. tiles inside renderDistance stay until the
+// full chunk replacing them is drawn (renderChunks)
+void handleLodChunks()
+{
+    int centerX = (int)playerChunkPos.x;
+    int centerZ = (int)playerChunkPos.y;
 
-    void buildVertices()
+    for (auto it = lodChunks.begin(); it != lodChunks.end();)
     {
-        genChunk();  // set blocks
-        buildMesh(); // build vertices array from blocks
-        verticesLoaded = true;
+        int distance = std::max(abs(it->first.first - centerX), abs(it->first.second - centerZ));
+        if (distance > lodDistance)
+            it = lodChunks.erase(it);
+        else
+            it++;
     }
 
-    void uploadToGpu()
+    std::vector<std::pair<int, std::pair<int, int>>> wanted; // distance, position
+    for (int x = centerX - lodDistance; x <= centerX + lodDistance; x++)
     {
-        if (verticesLoaded && !verticesUploaded)
+        for (int z = centerZ - lodDistance; z <= centerZ + lodDistance; z++)
         {
-            setVertices();
-            verticesUploaded = true;
+            int distance = std::max(abs(x - centerX), abs(z - centerZ));
+            if (distance > renderDistance)
+                wanted.push_back(std::make_pair(distance, std::make_pair(x, z)));
         }
     }
+    std::sort(wanted.begin(), wanted.end());
+
+    for (const auto &entry : wanted)
+    {
+        int scale = lodScaleAt(entry.first);
+        std::unique_ptr<LodChunk> &tile = lodChunks[entry.second];
+        if (!tile || tile->getScale() != scale)
+            tile = std::make_unique<LodChunk>(entry.second.first, entry.second.second, scale, std::move(tile));
+    }
+}
 
+// the simulation thread holds this for a whole tick. the render thread
+// takes it to add / remove chunks and to edit blocks, so a tick never sees
+// the chunk map or the blocks change under it
+std::mutex worldMutex;
 
-public:
-    ~Chunk()
+// null if the chunk isnt loaded or still being built
+Chunk *findEditableChunk(int chunkX, int chunkZ)
+{
+    auto it = chunks.find(std::make_pair(chunkX, chunkZ));
+    if (it == chunks.end() || !it->second->isEditable())
+        return nullptr;
+    return it->second.get();
+}
+
+// scheduled (water) and random (grass, leaves) block ticks, ticked by the
+// simulation thread. edits tell it what changed
+BlockTicker *blockTicker = nullptr;
+
+// AIR outside the world or in chunks that arent ready. under worldMutex
+int getBlock(int worldX, int y, int worldZ)
+{
+    if (y < 0 || y >= CHUNK_HEIGHT)
+        return AIR;
+    Chunk *chunk = findEditableChunk(worldToChunk(worldX), worldToChunk(worldZ));
+    return chunk ? chunk->getBlock(worldToLocal(worldX), y, worldToLocal(worldZ)) : AIR;
+}
+
+// block picking straight on the chunk storage, one map lookup per chunk the
+// ray crosses
+const float blockReach = 6.0f;
+int placeBlockType = STONE;
+
+// blocks of the loaded chunks, for the raycast and the physics. under
+// worldMutex, see Chunk::getBlocks
+const ChunkBlocks *findLoadedBlocks(int chunkX, int chunkZ)
+{
+    Chunk *chunk = findEditableChunk(chunkX, chunkZ);
+    return chunk ? &chunk->getBlocks() : nullptr;
+}
+
+bool pickBlock(RaycastHit &hit)
+{
+    return raycastBlocks(findLoadedBlocks, camPos.x, camPos.y, camPos.z, camFront.x, camFront.y, camFront.z, blockReach, hit);
+}
+
+// the same for the UI every frame, without waiting for a running tick: the
+// chunks the ray crosses (two at most within reach, mostly one) are copied
+// under their own lock. the render thread is the only one changing the
+// chunk map, so it can look chunks up without worldMutex
+bool pickBlockUnlocked(RaycastHit &hit)
+{
+    struct BlockBuffer
     {
-        glDeleteBuffers(1, &VBO);
+        ChunkBlocks blocks;
+    };
+    std::map<std::pair<int, int>, std::unique_ptr<BlockBuffer>> copies;
+    auto lookup = [&copies](int chunkX, int chunkZ) -> const ChunkBlocks * {
+        std::unique_ptr<BlockBuffer> &copy = copies[std::make_pair(chunkX, chunkZ)];
+        if (!copy)
+        {
+            Chunk *chunk = findEditableChunk(chunkX, chunkZ);
+            if (!chunk)
+                return nullptr;
+            copy.reset(new BlockBuffer());
+            chunk->copyBlocks(copy->blocks);
+        }
+        return &copy->blocks;
+    };
+    return raycastBlocks(lookup, camPos.x, camPos.y, camPos.z, camFront.x, camFront.y, camFront.z, blockReach, hit);
+}
+
+// the player is simulated on the simulation thread, one PHYSICS_STEP per
+// tick. the render thread only sees the last two ticks and blends them
+SimulationLoop *simulation = nullptr;
+PlayerBody player;                   // simulation thread only
+std::atomic<bool> playerPlaced{false}; // pushed out of the terrain since the world (re)loaded
+
+std::mutex playerStateMutex; // the three below
+PlayerInput playerInput;     // written by processInput
+PlayerBody playerPrevious;   // second to last tick
+PlayerBody playerCurrent;    // last tick
+
+// the sections the block tick writes of one tick touch, remeshed once per
+// chunk after it instead of once per cell. the random tick workers write
+// it too, hence the lock
+std::map<std::pair<int, int>, unsigned int> tickRemeshes;
+std::mutex tickRemeshesMutex;
+
+// -1 in chunks that arent ready, the tick rules stop there
+int getTickBlock(int worldX, int y, int worldZ)
+{
+    Chunk *chunk = findEditableChunk(worldToChunk(worldX), worldToChunk(worldZ));
+    return chunk ? chunk->getBlock(worldToLocal(worldX), y, worldToLocal(worldZ)) : -1;
+}
+
+void setTickBlock(int worldX, int y, int worldZ, int block)
+{
+    int chunkX = worldToChunk(worldX);
+    int chunkZ = worldToChunk(worldZ);
+    Chunk *chunk = findEditableChunk(chunkX, chunkZ);
+    if (!chunk)
+        return;
+
+    int localX = worldToLocal(worldX);
+    int localZ = worldToLocal(worldZ);
+    unsigned int sections = chunk->writeBlock(localX, y, localZ, block);
+
+    // the neighbor's side of a shared border, like setBlock
+    std::lock_guard<std::mutex> lock(tickRemeshesMutex);
+    tickRemeshes[std::make_pair(chunkX, chunkZ)] |= sections;
+    unsigned int section = 1u << (y / SECTION_HEIGHT);
+    if (localX == 0 || localX == CHUNK_WIDTH - 1)
+        tickRemeshes[std::make_pair(chunkX + (localX == 0 ? -1 : 1), chunkZ)] |= section;
+    if (localZ == 0 || localZ == CHUNK_WIDTH - 1)
+        tickRemeshes[std::make_pair(chunkX, chunkZ + (localZ == 0 ? -1 : 1))] |= section;
+}
+
+// the ready chunks with random ticked blocks, for the random tick pass
+void listTickChunks(std::vector<TickChunk> &list)
+{
+    for (auto &it : chunks)
+    {
+        Chunk *chunk = it.second.get();
+        if (!chunk->isEditable())
+            continue;
+        unsigned int sections = chunk->getRandomTickedSections();
+        if (sections != 0)
+            list.push_back(TickChunk{it.first.first, it.first.second, sections});
     }
+}
 
-    Chunk(int x, int z)
+// simulation thread, under worldMutex
+void tickBlocks()
+{
+    blockTicker->tick();
+    for (auto &it : tickRemeshes)
     {
-        // generate form (16x, 16z) to (16x + 15, 16z + 15)
-        initialX = x * 16;
-        initialZ = z * 16;
-        finalX = initialX + 15;
-        finalZ = initialZ + 15;
+        if (Chunk *chunk = findEditableChunk(it.first.first, it.first.second))
+            chunk->requestRemesh(it.second);
+    }
+    tickRemeshes.clear();
+}
+
+// runs on the simulation thread
+void simulationTick()
+{
+    std::lock_guard<std::mutex> worldLock(worldMutex);
 
-        std::thread chunkGen(&Chunk::buildVertices, this);
-        chunkGen.detach();
+    PlayerInput input;
+    {
+        std::lock_guard<std::mutex> lock(playerStateMutex);
+        input = playerInput;
     }
 
-    void renderChunk()
+    tickBlocks();
+
+    // hold still until the chunk under the player is there
+    if (findEditableChunk(worldToChunk((int)floor(player.position[0])), worldToChunk((int)floor(player.position[2]))))
     {
-        uploadToGpu(); // uploads vertices to GPU if its loaded
-        if (verticesUploaded)
+        PROFILE_SCOPE("physics");
+        if (!playerPlaced)
         {
-            // render all vertex from vertices
-            glBindVertexArray(VAO);
-            glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 7);
+            unstuckPlayer(player, findLoadedBlocks);
+            playerPlaced = true;
         }
+        stepPlayer(player, input, findLoadedBlocks);
     }
-};
 
-std::map<std::pair<int, int>, std::unique_ptr<Chunk>> chunks;
+    std::lock_guard<std::mutex> lock(playerStateMutex);
+    playerPrevious = playerCurrent;
+    playerCurrent = player;
+}
+
+// camera at the player's eyes, between the last two ticks
+void updateCamera()
+{
+    float alpha = simulation->getAlpha();
+    std::lock_guard<std::mutex> lock(playerStateMutex);
+    for (int i = 0; i < 3; i++)
+        camPos[i] = playerPrevious.position[i] + (playerCurrent.position[i] - playerPrevious.position[i]) * alpha;
+    camPos.y += PLAYER_EYE_HEIGHT;
+}
+
+// breaks / places a block. remeshes the chunk, and the neighbor too when the
+// block is on their shared border so its side of the border can follow.
+// false if out of the world or the chunk isnt ready
+bool setBlock(int worldX, int y, int worldZ, int type)
+{
+    if (y < 0 || y >= CHUNK_HEIGHT)
+        return false;
+
+    int chunkX = worldToChunk(worldX);
+    int chunkZ = worldToChunk(worldZ);
+    Chunk *chunk = findEditableChunk(chunkX, chunkZ);
+    if (!chunk)
+        return false;
+
+    int localX = worldToLocal(worldX);
+    int localZ = worldToLocal(worldZ);
+    if (chunk->getBlock(localX, y, localZ) == type)
+        return true;
+    chunk->setBlock(localX, y, localZ, type);
+
+    int neighborX = localX == 0 ? -1 : localX == CHUNK_WIDTH - 1 ? 1 : 0;
+    int neighborZ = localZ == 0 ? -1 : localZ == CHUNK_WIDTH - 1 ? 1 : 0;
+    if (neighborX != 0)
+    {
+        if (Chunk *neighbor = findEditableChunk(chunkX + neighborX, chunkZ))
+            neighbor->requestRemesh(1u << (y / SECTION_HEIGHT));
+    }
+    if (neighborZ != 0)
+    {
+        if (Chunk *neighbor = findEditableChunk(chunkX, chunkZ + neighborZ))
+            neighbor->requestRemesh(1u << (y / SECTION_HEIGHT));
+    }
+    blockTicker->blockChanged(worldX, y, worldZ);
+    return true;
+}
 
 void initChunks()
 {
+    // snapshot the current slider values, every chunk of this load shares it
+    worldGenerator = std::make_shared<const WorldGenerator>(worldParams);
+    regionStore = RegionStore::open(worldDirectory(worldParams));
+    playerPlaced = false;
+    blockTicker->clear();
+    lodChunks.clear();
+
     int fromX = -renderDistance;
     int fromZ = -renderDistance;
     int toX = renderDistance;
@@ -404,23 +915,139 @@ void initChunks()
     {
         for (int z = fromZ; z <= toZ; z++)
         {
-            chunks.emplace(std::make_pair(x, z), std::make_unique<Chunk>(x, z));
+            chunks.emplace(std::make_pair(x, z), std::make_unique<Chunk>(x, z, worldGenerator, regionStore));
         }
     }
+    handleLodChunks();
 }
 
+// sections and LOD tiles outside the view, or hidden behind the solid
+// columns of the chunks near the camera, are not drawn (OcclusionCuller).
+// further chunks rarely hide much more than they cost to rasterize
+OcclusionCuller occlusionCuller;
+int occlusionCulling = 1; // 0 leaves the view test only
+const int OCCLUDER_DISTANCE = 3;
+
+// neither are the sections no open path from the camera reaches, the
+// surface from a cave or buried sections (SectionGraph)
+SectionGraph sectionGraph;
+int caveCulling = 1;
+
+void cullChunks()
+{
+    PROFILE_SCOPE("cull");
+    uint64_t start = Profiler::nowMicros();
+    glm::mat4 viewProjection = projection * view;
+    occlusionCuller.beginFrame(glm::value_ptr(viewProjection));
+
+    if (occlusionCulling)
+    {
+        int cameraX = worldToChunk((int)std::floor(camPos.x));
+        int cameraZ = worldToChunk((int)std::floor(camPos.z));
+        for (int x = cameraX - OCCLUDER_DISTANCE; x <= cameraX + OCCLUDER_DISTANCE; x++)
+        {
+            for (int z = cameraZ - OCCLUDER_DISTANCE; z <= cameraZ + OCCLUDER_DISTANCE; z++)
+            {
+                auto it = chunks.find(std::make_pair(x, z));
+                if (it != chunks.end())
+                    it->second->addOccluders(occlusionCuller);
+            }
+        }
+    }
+
+    if (caveCulling)
+    {
+        sectionGraph.update(glm::value_ptr(camPos), glm::value_ptr(camFront), renderDistance + 1, [](int chunkX, int section, int chunkZ) -> const uint8_t * {
+            auto it = chunks.find(std::make_pair(chunkX, chunkZ));
+            return it == chunks.end() ? nullptr : it->second->getFaceConnections(section);
+        });
+    }
+
+    int graphCulled = 0;
+    for (auto itr = chunks.begin(); itr != chunks.end(); itr++)
+        graphCulled += itr->second->cull(occlusionCuller, caveCulling ? &sectionGraph : nullptr);
+    for (auto itr = lodChunks.begin(); itr != lodChunks.end(); itr++)
+        itr->second->cull(occlusionCuller);
+
+    const OcclusionCuller::Stats &stats = occlusionCuller.getStats();
+    Metrics::set(METRIC_CULL_TESTED, stats.tested);
+    Metrics::set(METRIC_FRUSTUM_CULLED, stats.frustumCulled);
+    Metrics::set(METRIC_OCCLUSION_CULLED, stats.occlusionCulled);
+    Metrics::set(METRIC_GRAPH_CULLED, graphCulled);
+    Metrics::set(METRIC_CULL_US, (int64_t)(Profiler::nowMicros() - start));
+}
+
+// opaque first, then leaves with their transparent texels discarded (both
+// without blending), then the translucent sections back to front blended
+// over them without writing depth
 void renderChunks()
 {
-    // render chunks map
+    for (auto itr = chunks.begin(); itr != chunks.end(); itr++)
+        itr->second->uploadToGpu(); // uploads vertices to GPU if its loaded
+
+    // a LOD tile goes once the full chunk in its place is drawn
+    for (auto itr = lodChunks.begin(); itr != lodChunks.end();)
+    {
+        auto full = chunks.find(itr->first);
+        if (full != chunks.end() && full->second->isUploaded())
+        {
+            itr = lodChunks.erase(itr);
+            continue;
+        }
+        itr->second->uploadToGpu();
+        itr++;
+    }
+
+    cullChunks();
+
+    for (auto itr = chunks.begin(); itr != chunks.end(); itr++)
+        for (int section = 0; section < SECTION_COUNT; section++)
+            itr->second->drawSection(section, LAYER_OPAQUE);
+    for (auto itr = lodChunks.begin(); itr != lodChunks.end(); itr++)
+        itr->second->draw(LAYER_OPAQUE);
+
+    shader->setInt("alphaTest", 1);
+    for (auto itr = chunks.begin(); itr != chunks.end(); itr++)
+        for (int section = 0; section < SECTION_COUNT; section++)
+            itr->second->drawSection(section, LAYER_CUTOUT);
+    for (auto itr = lodChunks.begin(); itr != lodChunks.end(); itr++)
+        itr->second->draw(LAYER_CUTOUT);
+    shader->setInt("alphaTest", 0);
+
+    struct TranslucentSection
+    {
+        Chunk *chunk;
+        int section;
+        float distance;
+    };
+    std::vector<TranslucentSection> translucent;
     for (auto itr = chunks.begin(); itr != chunks.end(); itr++)
     {
-        (itr->second)->renderChunk();
+        for (int section = 0; section < SECTION_COUNT; section++)
+        {
+            if (itr->second->hasLayer(section, LAYER_TRANSLUCENT))
+                translucent.push_back(TranslucentSection{itr->second.get(), section, itr->second->sectionDistance(section, camPos)});
+        }
     }
+    std::sort(translucent.begin(), translucent.end(), [](const TranslucentSection &a, const TranslucentSection &b) { return a.distance > b.distance; });
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    // the LOD tiles are all further than the full chunks
+    for (auto itr = lodChunks.begin(); itr != lodChunks.end(); itr++)
+        itr->second->draw(LAYER_TRANSLUCENT);
+    for (const TranslucentSection &entry : translucent)
+        entry.chunk->drawSection(entry.section, LAYER_TRANSLUCENT);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
 }
 
 // nuklear context
 struct nk_context *ctx;
 
+// frame time history for the stats panel
+FrameStats frameStats;
+
 int initNuklear(GLFWwindow *window)
 {
     ctx = nk_glfw3_init(window, NK_GLFW3_INSTALL_CALLBACKS);
@@ -463,26 +1090,38 @@ void drawDebugMenu()
         snprintf(buffer, sizeof(buffer), "X: %.2f Z: %.2f", playerChunkPos.x, playerChunkPos.y);
         nk_label(ctx, buffer, NK_TEXT_LEFT);
 
-        nk_label(ctx, "FPS:", NK_TEXT_LEFT);
-        snprintf(buffer, sizeof(buffer), "%.2f", 1.0f / deltaTime);
+        RaycastHit target;
+        if (pickBlockUnlocked(target))
+            snprintf(buffer, sizeof(buffer), "Target: %d %d %d (%.1f)", target.x, target.y, target.z, target.distance);
+        else
+            snprintf(buffer, sizeof(buffer), "Target: none");
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        nk_property_int(ctx, "#Place block:", GRASS, &placeBlockType, WATER, 1, 1);
+
+        SimulationLoop::Stats simStats = simulation->getStats();
+        snprintf(buffer, sizeof(buffer), "Ticks: %llu  Dropped: %llu", (unsigned long long)simStats.ticks, (unsigned long long)simStats.droppedTicks);
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Tick: %.2f ms (max %.2f)", simStats.lastTickMs, simStats.maxTickMs);
         nk_label(ctx, buffer, NK_TEXT_LEFT);
 
         float noiseMin = 0.0f;
         float noiseMax = 1.0f;
         float noiseStep = 0.05f;
 
-        snprintf(buffer, sizeof(buffer), "Noise Scale: %.2f", noise_scale);
+        snprintf(buffer, sizeof(buffer), "Noise Scale: %.2f", worldParams.noiseScale);
 
         nk_label(ctx, buffer, NK_TEXT_LEFT);
-        nk_slider_float(ctx, noiseMin, &noise_scale, noiseMax, noiseStep);
+        nk_slider_float(ctx, noiseMin, &worldParams.noiseScale, noiseMax, noiseStep);
 
         int minMaxH = 5;
         int maxMaxH = 50;
         int stepMaxH = 1;
 
-        snprintf(buffer, sizeof(buffer), "Max Height: %i", maxHeight);
+        snprintf(buffer, sizeof(buffer), "Max Height: %i", worldParams.maxHeight);
         nk_label(ctx, buffer, NK_TEXT_LEFT);
-        nk_slider_int(ctx, minMaxH, &maxHeight, maxMaxH, stepMaxH);
+        nk_slider_int(ctx, minMaxH, &worldParams.maxHeight, maxMaxH, stepMaxH);
+
+        nk_property_int(ctx, "#Seed:", 0, &worldParams.seed, 1 << 16, 1, 1);
 
         int minRenderDistance = 1;
         int maxRenderDistance = 30;
@@ -492,11 +1131,116 @@ void drawDebugMenu()
         nk_label(ctx, buffer, NK_TEXT_LEFT);
         nk_slider_int(ctx, minRenderDistance, &renderDistance, maxRenderDistance, stepRenderDistance);
 
+        // 0 (or anything up to the render distance) for no LOD tiles
+        snprintf(buffer, sizeof(buffer), "LOD Distance: %i", lodDistance);
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        nk_slider_int(ctx, 0, &lodDistance, 64, 1);
+
         if (nk_button_label(ctx, "Reload Chunks"))
         {
+            std::lock_guard<std::mutex> worldLock(worldMutex);
             chunks.clear();
             initChunks();
         }
+
+        // chunk pipeline and memory
+        nk_label(ctx, "Chunks:", NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Queued: %lld  Generating: %lld", (long long)Metrics::get(METRIC_CHUNKS_QUEUED), (long long)Metrics::get(METRIC_CHUNKS_GENERATING));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Meshed: %lld  Resident: %lld", (long long)Metrics::get(METRIC_CHUNKS_MESHED), (long long)Metrics::get(METRIC_CHUNKS_RESIDENT));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Loaded from disk: %lld  Saved: %lld", (long long)Metrics::get(METRIC_CHUNKS_LOADED_FROM_DISK), (long long)Metrics::get(METRIC_CHUNKS_SAVED));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Last edit to visible: %.2f ms", Metrics::get(METRIC_EDIT_LATENCY_US) / 1000.0);
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Unsaved: %lld  Autosaves: %lld", (long long)Metrics::get(METRIC_DIRTY_CHUNKS), (long long)Metrics::get(METRIC_AUTOSAVE_BATCHES));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Scheduled ticks: %lld  Random ticks: %lld", (long long)Metrics::get(METRIC_SCHEDULED_TICKS), (long long)Metrics::get(METRIC_RANDOM_TICKS));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        if (nk_button_label(ctx, "Save World"))
+            chunkSaver->requestSave();
+        snprintf(buffer, sizeof(buffer), "Blocks: %.1f MB", Metrics::get(METRIC_BLOCK_BYTES) / (1024.0 * 1024.0));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Vertices: %.1f MB (GPU %.1f MB)", Metrics::get(METRIC_VERTEX_BYTES) / (1024.0 * 1024.0), Metrics::get(METRIC_GPU_VERTEX_BYTES) / (1024.0 * 1024.0));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "LOD tiles: %lld (GPU %.1f MB)", (long long)Metrics::get(METRIC_LOD_CHUNKS), Metrics::get(METRIC_LOD_GPU_VERTEX_BYTES) / (1024.0 * 1024.0));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+
+        // sections and LOD tiles of the last frame
+        nk_checkbox_label(ctx, "Occlusion Culling", &occlusionCulling);
+        nk_checkbox_label(ctx, "Cave Culling", &caveCulling);
+        snprintf(buffer, sizeof(buffer), "Culled: %lld view  %lld hidden  %lld cave", (long long)Metrics::get(METRIC_FRUSTUM_CULLED), (long long)Metrics::get(METRIC_OCCLUSION_CULLED), (long long)Metrics::get(METRIC_GRAPH_CULLED));
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Graph sections walked: %d", caveCulling ? sectionGraph.getStats().visited : 0);
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "Of %lld tested in %.2f ms", (long long)Metrics::get(METRIC_CULL_TESTED), Metrics::get(METRIC_CULL_US) / 1000.0);
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+
+        if (nk_button_label(ctx, "Dump Metrics"))
+        {
+            if (!Metrics::dumpToFile("metrics.json"))
+                std::cerr << "Failed to write metrics.json" << std::endl;
+        }
+
+#if MINECRAFT_PROFILER
+        // writes trace.json next to the executable, open it in chrome://tracing
+        if (Profiler::isCapturing())
+        {
+            snprintf(buffer, sizeof(buffer), "Capturing... %i frames left", Profiler::captureFramesLeft());
+            nk_label(ctx, buffer, NK_TEXT_LEFT);
+        }
+        else if (nk_button_label(ctx, "Capture Trace (300 frames)"))
+        {
+            Profiler::beginCapture(300, "trace.json");
+        }
+#endif
+    }
+
+    nk_end(ctx);
+}
+
+// rolling frame time percentiles, a graph of the last frames and where the time went
+void drawFrameStatsMenu()
+{
+    int nuklear_window = nk_begin(ctx, "Frame Stats", nk_rect(SCREEN_WIDTH - 270, 10, 260, 400), NK_WINDOW_BORDER | NK_WINDOW_TITLE | NK_WINDOW_MINIMIZABLE | NK_WINDOW_MOVABLE);
+
+    if (nuklear_window)
+    {
+        FrameStats::Summary stats = frameStats.summarize();
+        char buffer[64];
+
+        nk_layout_row_dynamic(ctx, 20, 1);
+
+        snprintf(buffer, sizeof(buffer), "FPS (avg): %.1f", stats.avgMs > 0.0f ? 1000.0f / stats.avgMs : 0.0f);
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "p50: %.2f ms  p95: %.2f ms", stats.p50Ms, stats.p95Ms);
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        snprintf(buffer, sizeof(buffer), "p99: %.2f ms  max: %.2f ms", stats.p99Ms, stats.maxMs);
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+
+        // sparkline, scaled to at least two hitch thresholds so spikes stand out
+        float graphMax = std::max(frameStats.hitchThresholdMs * 2.0f, stats.maxMs);
+        nk_layout_row_dynamic(ctx, 60, 1);
+        if (frameStats.frameCount() > 0 && nk_chart_begin(ctx, NK_CHART_LINES, frameStats.frameCount(), 0.0f, graphMax))
+        {
+            for (int i = 0; i < frameStats.frameCount(); i++)
+            {
+                nk_chart_push(ctx, frameStats.frameMs(i));
+            }
+            nk_chart_end(ctx);
+        }
+
+        nk_layout_row_dynamic(ctx, 20, 1);
+        snprintf(buffer, sizeof(buffer), "Hitches > %.1f ms: %i (total %i)", frameStats.hitchThresholdMs, stats.hitches, frameStats.totalHitches());
+        nk_label(ctx, buffer, NK_TEXT_LEFT);
+        nk_slider_float(ctx, 8.0f, &frameStats.hitchThresholdMs, 100.0f, 0.5f);
+
+        nk_label(ctx, "Phase avg / max (ms):", NK_TEXT_LEFT);
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+        {
+            snprintf(buffer, sizeof(buffer), "%s: %.2f / %.2f", framePhaseName((FramePhase)phase), stats.phaseAvgMs[phase], stats.phaseMaxMs[phase]);
+            nk_label(ctx, buffer, NK_TEXT_LEFT);
+        }
     }
 
     nk_end(ctx);
@@ -524,9 +1268,8 @@ void initialization(GLFWwindow *window)
 
     glfwSetCursorPosCallback(window, mouse_callback);
 
-    // enables alpha to work (currently not working even with this code)
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // blending only in the translucent pass, see renderChunks
+    glDisable(GL_BLEND);
 
     // set the texture to fragment shader
     glActiveTexture(GL_TEXTURE0);
@@ -536,7 +1279,20 @@ void initialization(GLFWwindow *window)
 
     playBgm();
     initNuklear(window);
+
+    chunkSaver = new ChunkSaver();
+    chunkWorkers = new ThreadPool(0, "chunk worker");
+    lodWorkers = new ThreadPool(1, "lod worker");
+    blockTicker = new BlockTicker(TickWorld{getTickBlock, setTickBlock, listTickChunks});
     initChunks();
+
+    // spawn on the terrain, trees are handled by unstuckPlayer
+    player.position[0] = camPos.x;
+    player.position[2] = camPos.z;
+    player.position[1] = (float)worldGenerator->getTerrainY((int)floor(camPos.x), (int)floor(camPos.z));
+    playerPrevious = playerCurrent = player;
+
+    simulation = new SimulationLoop(PHYSICS_STEP, simulationTick, "simulation");
 }
 
 int main()
@@ -573,15 +1329,37 @@ int main()
 
     // like unity, update loop
     // game loop
+    PROFILE_THREAD("main");
     while (!glfwWindowShouldClose(window))
     {
-        processInput(window);
-
-        glfwPollEvents();
+        {
+            FRAME_PHASE(frameStats, PHASE_INPUT);
+            processInput(window);
+        }
+        {
+            FRAME_PHASE(frameStats, PHASE_EVENTS);
+            glfwPollEvents();
+        }
         display();
-        glfwSwapBuffers(window);
+        {
+            FRAME_PHASE(frameStats, PHASE_SWAP);
+            glfwSwapBuffers(window);
+        }
+        PROFILE_FRAME();
+        frameStats.endFrame();
     }
 
+    // GL buffers go before the context, then stop the workers. the saver
+    // writes the edits of the chunks just dropped
+    delete simulation;
+    delete blockTicker;
+    chunks.clear();
+    lodChunks.clear();
+    delete chunkWorkers;
+    delete lodWorkers;
+    delete chunkSaver;
+    regionStore.reset(); // writes whatever is still queued
+
     nk_glfw3_shutdown();
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -590,33 +1368,48 @@ int main()
 
 bool cursorLocked = true;
 bool escPressedLastFrame = false; // define this globally or persistently
+bool breakPressedLastFrame = false;
+bool placePressedLastFrame = false;
+bool flyPressedLastFrame = false;
 
 void processInput(GLFWwindow *window)
 {
+    // movement goes to the simulation thread, see simulationTick
+    glm::vec3 forward = glm::vec3(camFront.x, 0.0f, camFront.z);
+    if (glm::length(forward) > 0.0f)
+        forward = glm::normalize(forward);
+    glm::vec3 wish = glm::vec3(0.0f);
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
     {
-        camPos += camFront * deltaTime * camSpeed;
+        wish += forward;
     }
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
     {
-        camPos -= camFront * deltaTime * camSpeed;
+        wish -= forward;
     }
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
     {
-        camPos += camRight * deltaTime * camSpeed;
+        wish += camRight;
     }
     if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
     {
-        camPos -= camRight * deltaTime * camSpeed;
-    }
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
-    {
-        camPos += up * deltaTime * camSpeed;
+        wish -= camRight;
     }
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+    if (glm::length(wish) > 1.0f)
+        wish = glm::normalize(wish);
+
+    // F toggles flying
+    bool flyPressed = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
     {
-        camPos -= up * deltaTime * camSpeed;
+        std::lock_guard<std::mutex> lock(playerStateMutex);
+        playerInput.moveX = wish.x;
+        playerInput.moveZ = wish.z;
+        playerInput.jump = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+        playerInput.descend = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
+        if (flyPressed && !flyPressedLastFrame)
+            playerInput.flying = !playerInput.flying;
     }
+    flyPressedLastFrame = flyPressed;
 
     bool escPressed = glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS;
 
@@ -637,6 +1430,42 @@ void processInput(GLFWwindow *window)
     }
 
     escPressedLastFrame = escPressed;
+
+    // left click breaks the targeted block, right click places one against
+    // the face it was hit on. only while the cursor is captured, otherwise
+    // the clicks belong to the menus
+    bool breakPressed = cursorLocked && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    bool placePressed = cursorLocked && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+    if ((breakPressed && !breakPressedLastFrame) || (placePressed && !placePressedLastFrame))
+    {
+        std::lock_guard<std::mutex> worldLock(worldMutex);
+        RaycastHit hit;
+        if (pickBlock(hit))
+        {
+            if (breakPressed && !breakPressedLastFrame)
+            {
+                setBlock(hit.x, hit.y, hit.z, AIR);
+            }
+            else
+            {
+                int x = hit.x + hit.normalX;
+                int y = hit.y + hit.normalY;
+                int z = hit.z + hit.normalZ;
+                PlayerBody body;
+                {
+                    std::lock_guard<std::mutex> lock(playerStateMutex);
+                    body = playerCurrent;
+                }
+                if (!playerOverlapsBlock(body, x, y, z) && !isSolidBlock(getBlock(x, y, z)))
+                {
+                    // placed leaves never decay
+                    setBlock(x, y, z, placeBlockType == LEAVES ? makeBlock(LEAVES, LEAVES_PERSISTENT) : placeBlockType);
+                }
+            }
+        }
+    }
+    breakPressedLastFrame = breakPressed;
+    placePressedLastFrame = placePressed;
 }
 
 unsigned int loadTexture(const char *texLocation)
@@ -757,6 +1586,8 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 
 void handleChunks()
 {
+    std::lock_guard<std::mutex> worldLock(worldMutex);
+
     int fromX = playerChunkPos.x - renderDistance;
     int fromZ = playerChunkPos.y - renderDistance;
     int toX = playerChunkPos.x + renderDistance;
@@ -772,7 +1603,7 @@ void handleChunks()
             if (chunks.find(pos) == chunks.end())
             {
                 // it do not exists
-                chunks.emplace(std::make_pair(x, z), std::make_unique<Chunk>(x, z));
+                chunks.emplace(std::make_pair(x, z), std::make_unique<Chunk>(x, z, worldGenerator, regionStore));
             }
         }
     }
@@ -794,6 +1625,8 @@ void handleChunks()
             it++;
         }
     }
+
+    handleLodChunks();
 }
 
 void updatePlayerChunkPos()
@@ -818,6 +1651,7 @@ void restoreState()
     // Restore critical OpenGL state
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
+    glDisable(GL_BLEND); // the ui blends
     glBindVertexArray(cubeVAO);
     shader->use();
     glm::mat4 model = glm::mat4(1.0f); // identity
@@ -830,18 +1664,34 @@ void restoreState()
 
 void display()
 {
+    PROFILE_SCOPE("display");
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // state using
     calcDeltaTime();
-    setMatrix();
-
-    updatePlayerChunkPos();
-    renderChunks();
-
-    nk_glfw3_new_frame();
-    drawDebugMenu();
-    nk_glfw3_render(NK_ANTI_ALIASING_ON, 512 * 1024, 128 * 1024);
-    // 512 * 1024   // max vertex buffer size = 512 KB
-    // 128 * 1024   // max element buffer size = 128 KB
-
-    restoreState();
+    {
+        FRAME_PHASE(frameStats, PHASE_MATRIX);
+        updateCamera();
+        setMatrix();
+    }
+    {
+        FRAME_PHASE(frameStats, PHASE_CHUNK_UPDATE);
+        updatePlayerChunkPos();
+    }
+    {
+        FRAME_PHASE(frameStats, PHASE_RENDER_CHUNKS);
+        renderChunks();
+    }
+    {
+        FRAME_PHASE(frameStats, PHASE_UI);
+        nk_glfw3_new_frame();
+        drawDebugMenu();
+        drawFrameStatsMenu();
+        nk_glfw3_render(NK_ANTI_ALIASING_ON, 512 * 1024, 128 * 1024);
+        // 512 * 1024   // max vertex buffer size = 512 KB
+        // 128 * 1024   // max element buffer size = 128 KB
+    }
+    {
+        FRAME_PHASE(frameStats, PHASE_RESTORE);
+        restoreState();
+    }
 }
\ No newline at end of file
@@ -12,17 +12,36 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "STB/stb_image.h"
-#define STB_PERLIN_IMPLEMENTATION
-#include "STB/stb_perlin.h"
+
+// world generation (no GL in there)
+#include "World/WorldGenerator.hpp"
+#include "World/ChunkMesher.hpp"
+#include "World/ChunkData.hpp"
+#include "World/Raycast.hpp"
+#include "World/BlockTicks.hpp"
+#include "Render/OcclusionCuller.hpp"
+#include "Render/SectionGraph.hpp"
+#include "Physics/PlayerPhysics.hpp"
+#include "Core/ThreadPool.hpp"
+#include "Core/SimulationLoop.hpp"
+#include "Storage/RegionStore.hpp"
+#include "Storage/ChunkSaver.hpp"
+
+// frame / worker timing, Chrome trace export
+#include "Profiler/Profiler.hpp"
+#include "Profiler/FrameStats.hpp"
+#include "Profiler/Metrics.hpp"
 
 // glm (opengl Mathematic) library
 #include "glm/glm.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-// audio system
+// audio system (optional, see MINECRAFT_WITH_AUDIO in CMakeLists.txt)
+#ifdef MINECRAFT_AUDIO
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
+#endif
 
 // Nuklear includes with implementation
 #define NK_INCLUDE_FIXED_TYPES
@@ -83,13 +102,14 @@ float yOffset;
 float lastX;
 float lastY;
 float sensitivity = 0.1f;
-float camSpeed = 10.0f;
 
 // player chunk position
 glm::vec2 playerChunkPos = glm::vec2(0.0f, 0.0f); // x-> x , y-> z
 
+#ifdef MINECRAFT_AUDIO
 // background music file pointer
 Mix_Music* bgm = nullptr;
+#endif
 
 // helper functions
 void display();
@@ -0,0 +1,297 @@
+// raycastBlocks unit tests, run by ctest
+//
+// every case builds a small world of hand placed blocks (chunks not placed
+// are unloaded) and checks the hit, its face normal and distance. the
+// random rays are checked against a fine march along the same ray.
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+
+#include "World/Raycast.hpp"
+
+struct BlockBuffer
+{
+    ChunkBlocks blocks;
+};
+
+struct TestWorld
+{
+    std::map<std::pair<int, int>, std::unique_ptr<BlockBuffer>> chunks;
+    int lookups = 0;
+
+    // an empty (air) chunk
+    void load(int chunkX, int chunkZ)
+    {
+        std::unique_ptr<BlockBuffer> &buffer = chunks[std::make_pair(chunkX, chunkZ)];
+        if (!buffer)
+        {
+            buffer.reset(new BlockBuffer());
+            memset(buffer->blocks, 0, sizeof(ChunkBlocks));
+        }
+    }
+
+    void set(int x, int y, int z, int block)
+    {
+        load(worldToChunk(x), worldToChunk(z));
+        chunks[std::make_pair(worldToChunk(x), worldToChunk(z))]->blocks[worldToLocal(x)][y][worldToLocal(z)] = block;
+    }
+
+    int get(int x, int y, int z) const
+    {
+        auto it = chunks.find(std::make_pair(worldToChunk(x), worldToChunk(z)));
+        if (it == chunks.end() || y < 0 || y >= CHUNK_HEIGHT)
+            return AIR;
+        return it->second->blocks[worldToLocal(x)][y][worldToLocal(z)];
+    }
+
+    ChunkLookup lookup()
+    {
+        return [this](int chunkX, int chunkZ) -> const ChunkBlocks * {
+            lookups++;
+            auto it = chunks.find(std::make_pair(chunkX, chunkZ));
+            return it == chunks.end() ? nullptr : &it->second->blocks;
+        };
+    }
+
+    bool cast(float x, float y, float z, float dirX, float dirY, float dirZ, float maxDistance, RaycastHit &hit)
+    {
+        return raycastBlocks(lookup(), x, y, z, dirX, dirY, dirZ, maxDistance, hit);
+    }
+};
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+static bool near(float a, float b)
+{
+    return std::fabs(a - b) < 1e-4f;
+}
+
+static void checkHit(const RaycastHit &hit, int x, int y, int z, int normalX, int normalY, int normalZ, float distance)
+{
+    CHECK(hit.x == x && hit.y == y && hit.z == z);
+    CHECK(hit.normalX == normalX && hit.normalY == normalY && hit.normalZ == normalZ);
+    CHECK(near(hit.distance, distance));
+}
+
+static void testAxisAligned()
+{
+    TestWorld world;
+    world.load(0, 0);
+    world.set(5, 10, 0, STONE);
+    RaycastHit hit;
+    CHECK(world.cast(0.5f, 10.5f, 0.5f, 1.0f, 0.0f, 0.0f, 10.0f, hit));
+    checkHit(hit, 5, 10, 0, -1, 0, 0, 4.5f);
+    CHECK(hit.type == STONE);
+
+    // the direction doesnt have to be normalized
+    CHECK(world.cast(0.5f, 10.5f, 0.5f, 7.0f, 0.0f, 0.0f, 10.0f, hit));
+    checkHit(hit, 5, 10, 0, -1, 0, 0, 4.5f);
+
+    // water is passed through
+    world.set(3, 10, 0, WATER);
+    CHECK(world.cast(0.5f, 10.5f, 0.5f, 1.0f, 0.0f, 0.0f, 10.0f, hit));
+    checkHit(hit, 5, 10, 0, -1, 0, 0, 4.5f);
+}
+
+static void testFaceNormals()
+{
+    TestWorld world;
+    world.load(0, 0);
+    world.set(8, 10, 8, STONE);
+
+    // from 3 blocks away on each side, through the middle of the face
+    const int sides[6][3] = {{0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}};
+    for (const int *side : sides)
+    {
+        RaycastHit hit;
+        CHECK(world.cast(8.5f + side[0] * 3, 10.5f + side[1] * 3, 8.5f + side[2] * 3, (float)-side[0], (float)-side[1], (float)-side[2], 10.0f, hit));
+        checkHit(hit, 8, 10, 8, side[0], side[1], side[2], 2.5f);
+    }
+}
+
+static void testDiagonal()
+{
+    TestWorld world;
+    world.load(0, 0);
+    world.set(4, 12, 6, STONE);
+
+    // from (0.5, 10.5, 0.5) to the middle of the block's bottom face, so it
+    // enters through the bottom one direction length away
+    float dirX = 4.0f, dirY = 1.5f, dirZ = 6.0f;
+    RaycastHit hit;
+    CHECK(world.cast(0.5f, 10.5f, 0.5f, dirX, dirY, dirZ, 20.0f, hit));
+    float length = std::sqrt(dirX * dirX + dirY * dirY + dirZ * dirZ);
+    checkHit(hit, 4, 12, 6, 0, -1, 0, length);
+}
+
+static void testNegativeCoordinates()
+{
+    TestWorld world;
+    world.load(-1, -1);
+    world.set(-5, 10, -1, STONE);
+    RaycastHit hit;
+    CHECK(world.cast(-0.5f, 10.5f, -0.5f, -1.0f, 0.0f, 0.0f, 10.0f, hit));
+    checkHit(hit, -5, 10, -1, 1, 0, 0, 3.5f);
+
+    // and across the border into positive x, chunk -1 to 0
+    world.load(0, -1);
+    world.set(2, 10, -1, DIRT);
+    CHECK(world.cast(-0.5f, 10.5f, -0.5f, 1.0f, 0.0f, 0.0f, 10.0f, hit));
+    checkHit(hit, 2, 10, -1, -1, 0, 0, 2.5f);
+    CHECK(hit.type == DIRT);
+}
+
+static void testChunkBorder()
+{
+    TestWorld world;
+    world.load(0, 0);
+    world.set(18, 10, 3, STONE);
+    RaycastHit hit;
+    world.lookups = 0;
+    CHECK(world.cast(14.5f, 10.5f, 3.5f, 1.0f, 0.0f, 0.0f, 10.0f, hit));
+    checkHit(hit, 18, 10, 3, -1, 0, 0, 3.5f);
+
+    // one lookup per chunk, not per block
+    CHECK(world.lookups == 2);
+}
+
+static void testMaxDistance()
+{
+    TestWorld world;
+    world.load(0, 0);
+    world.set(6, 10, 0, STONE);
+    RaycastHit hit;
+    CHECK(!world.cast(0.5f, 10.5f, 0.5f, 1.0f, 0.0f, 0.0f, 5.0f, hit));
+    CHECK(world.cast(0.5f, 10.5f, 0.5f, 1.0f, 0.0f, 0.0f, 5.5f, hit));
+    checkHit(hit, 6, 10, 0, -1, 0, 0, 5.5f);
+}
+
+static void testOriginInsideBlock()
+{
+    TestWorld world;
+    world.load(0, 0);
+    world.set(2, 10, 2, LOG);
+    RaycastHit hit;
+    CHECK(world.cast(2.3f, 10.7f, 2.9f, 1.0f, -1.0f, 0.5f, 10.0f, hit));
+    checkHit(hit, 2, 10, 2, 0, 0, 0, 0.0f);
+    CHECK(hit.type == LOG);
+}
+
+static void testLeavingWorld()
+{
+    TestWorld world;
+    world.load(0, 0);
+    world.set(3, 0, 3, BEDROCK);
+    RaycastHit hit;
+
+    // up and out of the top, down and out of the bottom, nothing there
+    CHECK(!world.cast(0.5f, 30.5f, 0.5f, 0.1f, 1.0f, 0.0f, 1000.0f, hit));
+    CHECK(!world.cast(0.5f, 1.5f, 0.5f, 0.0f, -1.0f, 0.1f, 1000.0f, hit));
+
+    // from above the world back into it
+    CHECK(world.cast(3.5f, 40.5f, 3.5f, 0.0f, -1.0f, 0.0f, 1000.0f, hit));
+    checkHit(hit, 3, 0, 3, 0, 1, 0, 39.5f);
+}
+
+static void testUnloadedChunk()
+{
+    TestWorld world;
+    world.load(0, 0);
+    world.set(40, 10, 3, STONE); // chunk 2, chunk 1 is never loaded
+    RaycastHit hit;
+    world.lookups = 0;
+    CHECK(!world.cast(14.5f, 10.5f, 3.5f, 1.0f, 0.0f, 0.0f, 100.0f, hit));
+    CHECK(world.lookups == 2);
+
+    // starting in one
+    CHECK(!world.cast(20.5f, 10.5f, 3.5f, 1.0f, 0.0f, 0.0f, 100.0f, hit));
+}
+
+// the first solid block a march of tiny steps finds, its distance or -1
+static float march(const TestWorld &world, float x, float y, float z, float dirX, float dirY, float dirZ, float maxDistance)
+{
+    float length = std::sqrt(dirX * dirX + dirY * dirY + dirZ * dirZ);
+    for (float t = 0.0f; t <= maxDistance; t += 0.0005f)
+    {
+        float px = x + dirX / length * t, py = y + dirY / length * t, pz = z + dirZ / length * t;
+        if (isSolidBlock(world.get((int)std::floor(px), (int)std::floor(py), (int)std::floor(pz))))
+            return t;
+    }
+    return -1.0f;
+}
+
+static void testAgainstMarch()
+{
+    TestWorld world;
+    std::mt19937 random(7);
+    for (int chunkX = -1; chunkX <= 0; chunkX++)
+        for (int chunkZ = -1; chunkZ <= 0; chunkZ++)
+            world.load(chunkX, chunkZ);
+    for (int i = 0; i < 600; i++)
+        world.set((int)(random() % 32) - 16, (int)(random() % 8) + 6, (int)(random() % 32) - 16, STONE);
+
+    std::uniform_real_distribution<float> position(-6.0f, 6.0f), direction(-1.0f, 1.0f);
+    const float maxDistance = 8.0f;
+    int rays = 0, hits = 0;
+    for (int i = 0; i < 300; i++)
+    {
+        float x = position(random), y = 10.0f + position(random) * 0.5f, z = position(random);
+        float dirX = direction(random), dirY = direction(random), dirZ = direction(random);
+        if (isSolidBlock(world.get((int)std::floor(x), (int)std::floor(y), (int)std::floor(z))))
+            continue;
+        float expected = march(world, x, y, z, dirX, dirY, dirZ, maxDistance);
+        // too close to the cutoff to tell which side the march lands on
+        if (std::fabs(expected - maxDistance) < 0.01f)
+            continue;
+
+        RaycastHit hit;
+        bool found = world.cast(x, y, z, dirX, dirY, dirZ, maxDistance, hit);
+        rays++;
+        CHECK(found == (expected >= 0.0f));
+        if (found && expected >= 0.0f)
+        {
+            hits++;
+            // the march overshoots the border by less than a step
+            CHECK(hit.distance <= expected && expected - hit.distance < 0.001f);
+            CHECK(isSolidBlock(world.get(hit.x, hit.y, hit.z)));
+        }
+    }
+    CHECK(rays > 200 && hits > 50);
+}
+
+int main()
+{
+    testAxisAligned();
+    testFaceNormals();
+    testDiagonal();
+    testNegativeCoordinates();
+    testChunkBorder();
+    testMaxDistance();
+    testOriginInsideBlock();
+    testLeavingWorld();
+    testUnloadedChunk();
+    testAgainstMarch();
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("raycast tests passed\n");
+    return 0;
+}